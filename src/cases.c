@@ -0,0 +1,1161 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#include "cases.h"
+
+#include "dataset.h"
+#include "ini.h"
+#include "pipeline.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *
+ * Set the configuration parameters of an axis from one of its values.
+ * Returns -1 for an invalid value.
+ *
+ */
+
+static int is_one_of(const char* value, const char* const allowed[])
+{
+  unsigned int i;
+  for (i = 0; allowed[i] != NULL; ++i)
+    if (strcmp(value, allowed[i]) == 0)
+      return 1;
+  return 0;
+}
+
+/* Copy a value into a configuration field, -1 if it doesn't fit */
+
+static int set_field(char* field, size_t size, const char* value)
+{
+  size_t len = strlen(value);
+  if (len >= size)
+    return -1;
+  memcpy(field, value, len + 1);
+  return 0;
+}
+
+static int parse_flag(const char* value)
+{
+  if (strcmp(value, "true") == 0 || strcmp(value, "1") == 0)
+    return 1;
+  if (strcmp(value, "false") == 0 || strcmp(value, "0") == 0)
+    return 0;
+  return -1;
+}
+
+static int apply_rank(configuration* pconfig, const char* value)
+{
+  int rank = atoi(value);
+  if (rank < 2 || rank > 4)
+    return -1;
+  pconfig->rank = (unsigned int)rank;
+  return 0;
+}
+
+static int apply_slowdim(configuration* pconfig, const char* value)
+{
+  static const char* const allowed[] = { "step", "array", NULL };
+  if (!is_one_of(value, allowed))
+    return -1;
+  return set_field(pconfig->slowest_dimension, sizeof(pconfig->slowest_dimension), value);
+}
+
+static int apply_layout(configuration* pconfig, const char* value)
+{
+  static const char* const allowed[] =
+    { "contiguous", "chunked", "compact", "virtual", NULL };
+  if (!is_one_of(value, allowed))
+    return -1;
+  return set_field(pconfig->layout, sizeof(pconfig->layout), value);
+}
+
+static int apply_fill(configuration* pconfig, const char* value)
+{
+  static const char* const allowed[] = { "true", "false", NULL };
+  if (!is_one_of(value, allowed))
+    return -1;
+  return set_field(pconfig->fill_values, sizeof(pconfig->fill_values), value);
+}
+
+/* COUNT[:SIZE], attributes of SIZE bytes (default 8) per dataset; larger
+   attributes than 64 KiB need dense attribute storage */
+
+static int apply_attributes(configuration* pconfig, const char* value)
+{
+  char buf[AXIS_VALUE_LEN];
+  char* sep;
+  unsigned long long size = 8;
+
+  if (set_field(buf, sizeof(buf), value) < 0)
+    return -1;
+  if ((sep = strchr(buf, ':')) != NULL)
+    {
+      *sep = '\0';
+      if (parse_size(sep + 1, &size) < 0 || size < 1 || size > 65536)
+        return -1;
+    }
+  if (atoi(buf) < 0 || (atoi(buf) == 0 && strcmp(buf, "0") != 0))
+    return -1;
+  pconfig->attributes = (unsigned int)atoi(buf);
+  pconfig->attribute_size = (size_t)size;
+  return 0;
+}
+
+/* MAX_COMPACT:MIN_DENSE (see H5Pset_attr_phase_change) */
+
+static int apply_phase_change(configuration* pconfig, const char* value)
+{
+  unsigned int max_compact, min_dense;
+
+  if (sscanf(value, "%u:%u", &max_compact, &min_dense) != 2 ||
+      max_compact > 65535 || min_dense > max_compact + 1)
+    return -1;
+  pconfig->attr_max_compact = max_compact;
+  pconfig->attr_min_dense = min_dense;
+  return 0;
+}
+
+static int apply_track_times(configuration* pconfig, const char* value)
+{
+  int flag = parse_flag(value);
+  if (flag < 0)
+    return -1;
+  pconfig->track_times = (unsigned int)flag;
+  return 0;
+}
+
+static int apply_no_attrs_hint(configuration* pconfig, const char* value)
+{
+  int flag = parse_flag(value);
+  if (flag < 0)
+    return -1;
+  pconfig->no_attrs_hint = (unsigned int)flag;
+  return 0;
+}
+
+/* INCREMENT[:THRESHOLD] */
+
+static int apply_alignment(configuration* pconfig, const char* value)
+{
+  char buf[AXIS_VALUE_LEN];
+  char* sep;
+  unsigned long long incr, thold = 0;
+
+  if (set_field(buf, sizeof(buf), value) < 0)
+    return -1;
+  if ((sep = strchr(buf, ':')) != NULL)
+    {
+      *sep = '\0';
+      if (parse_size(sep + 1, &thold) < 0)
+        return -1;
+    }
+  if (parse_size(buf, &incr) < 0 || incr < 1)
+    return -1;
+  pconfig->alignment_increment = (hsize_t)incr;
+  pconfig->alignment_threshold = (hsize_t)thold;
+  return 0;
+}
+
+static int apply_mblk(configuration* pconfig, const char* value)
+{
+  unsigned long long size;
+  if (parse_size(value, &size) < 0)
+    return -1;
+  pconfig->meta_block_size = (hsize_t)size;
+  return 0;
+}
+
+static int apply_page_size(configuration* pconfig, const char* value)
+{
+  unsigned long long size;
+  /* the library's minimum page size is 512 bytes */
+  if (parse_size(value, &size) < 0 || (size > 0 && size < 512))
+    return -1;
+  pconfig->fspace_page_size = (hsize_t)size;
+  return 0;
+}
+
+static int apply_page_buffer(configuration* pconfig, const char* value)
+{
+  unsigned long long size;
+  if (parse_size(value, &size) < 0)
+    return -1;
+  pconfig->page_buffer_size = (size_t)size;
+  return 0;
+}
+
+/* the metadata cache size bounds of the library (see H5ACpublic.h) */
+#define MDC_MIN_SIZE 1024
+#define MDC_MAX_SIZE (128*1024*1024)
+
+static int apply_mdc_config(configuration* pconfig, const char* value)
+{
+  size_t init, min, max;
+  double flash;
+
+  if (strcmp(value, "default") != 0)
+    {
+      if (parse_mdc_config(value, &init, &min, &max, &flash) < 0 ||
+          min < MDC_MIN_SIZE || max > MDC_MAX_SIZE || min > init ||
+          init > max || flash < 0.0 || flash > 10.0)
+        return -1;
+    }
+  return set_field(pconfig->mdc_config, sizeof(pconfig->mdc_config), value);
+}
+
+static int apply_evict(configuration* pconfig, const char* value)
+{
+  int flag = parse_flag(value);
+  if (flag < 0)
+    return -1;
+  pconfig->evict_on_close = (unsigned int)flag;
+  return 0;
+}
+
+static int apply_mdc_image(configuration* pconfig, const char* value)
+{
+  int flag = parse_flag(value);
+  if (flag < 0)
+    return -1;
+  pconfig->mdc_image = (unsigned int)flag;
+  return 0;
+}
+
+static int apply_shape(configuration* pconfig, const char* value)
+{
+  hsize_t crows, ccols;
+  if (set_field(pconfig->chunk_shape, sizeof(pconfig->chunk_shape), value) < 0)
+    return -1;
+  return chunk_shape(pconfig, &crows, &ccols);
+}
+
+/* NSLOTS:NBYTES:W0 */
+
+static int apply_cache(configuration* pconfig, const char* value)
+{
+  char buf[AXIS_VALUE_LEN];
+  char *nbytes, *w0;
+  unsigned long long size;
+
+  if (set_field(buf, sizeof(buf), value) < 0)
+    return -1;
+  if ((nbytes = strchr(buf, ':')) == NULL ||
+      (w0 = strchr(nbytes + 1, ':')) == NULL)
+    return -1;
+  *nbytes++ = '\0';
+  *w0++ = '\0';
+  if (atol(buf) < 1 || parse_size(nbytes, &size) < 0 ||
+      atof(w0) < 0.0 || atof(w0) > 1.0)
+    return -1;
+  pconfig->chunk_cache_nslots = (size_t)atol(buf);
+  pconfig->chunk_cache_nbytes = (size_t)size;
+  pconfig->chunk_cache_w0     = atof(w0);
+  return 0;
+}
+
+static int apply_filter(configuration* pconfig, const char* value)
+{
+  /* this also checks that the filters are available */
+  if (pipeline_check(value) < 0)
+    return -1;
+  return set_field(pconfig->filter, sizeof(pconfig->filter), value);
+}
+
+static int apply_chunk_write(configuration* pconfig, const char* value)
+{
+  static const char* const allowed[] = { "library", "direct", NULL };
+  if (!is_one_of(value, allowed))
+    return -1;
+  return set_field(pconfig->chunk_write, sizeof(pconfig->chunk_write), value);
+}
+
+static int apply_libver(configuration* pconfig, const char* value)
+{
+  static const char* const allowed[] =
+    { "earliest", "v18", "v110", "v112", "v114", "latest", NULL };
+  if (!is_one_of(value, allowed))
+    return -1;
+  return set_field(pconfig->libver_bound_low, sizeof(pconfig->libver_bound_low), value);
+}
+
+/* shared, per-rank, or per-group:G (G files) */
+
+static int apply_files(configuration* pconfig, const char* value)
+{
+  unsigned int groups;
+
+  if (strcmp(value, "shared") == 0)
+    pconfig->file_groups = 1;
+  else if (strcmp(value, "per-rank") == 0)
+    pconfig->file_groups = 0;
+  else if (sscanf(value, "per-group:%u", &groups) == 1 && groups > 0)
+    pconfig->file_groups = groups;
+  else
+    return -1;
+  return 0;
+}
+
+static int apply_multi(configuration* pconfig, const char* value)
+{
+  int flag = parse_flag(value);
+  if (flag < 0)
+    return -1;
+  pconfig->multi_dataset = (unsigned int)flag;
+  return 0;
+}
+
+static int apply_subfiling(configuration* pconfig, const char* value)
+{
+  int flag = parse_flag(value);
+  if (flag < 0)
+    return -1;
+  pconfig->subfiling = (unsigned int)flag;
+  return 0;
+}
+
+static int apply_read_pattern(configuration* pconfig, const char* value)
+{
+  static const char* const allowed[] =
+    { "replay", "random", "time-series", "strided", "column-slab", NULL };
+  if (!is_one_of(value, allowed))
+    return -1;
+  return set_field(pconfig->read_pattern, sizeof(pconfig->read_pattern), value);
+}
+
+static int apply_mpi_io(configuration* pconfig, const char* value)
+{
+  static const char* const allowed[] = { "independent", "collective", NULL };
+  if (!is_one_of(value, allowed))
+    return -1;
+  return set_field(pconfig->mpi_io, sizeof(pconfig->mpi_io), value);
+}
+
+/* none, or KEY=VALUE terms joined by + */
+
+static int apply_mpi_hints(configuration* pconfig, const char* value)
+{
+  const char *p, *eq;
+  size_t len;
+
+  if (strcmp(value, "none") != 0)
+    for (p = value; ; p += len + 1)
+      {
+        len = strcspn(p, "+");
+        eq = memchr(p, '=', len);
+        if (eq == NULL || eq == p || eq == p + len - 1)
+          return -1;
+        if (p[len] == '\0')
+          break;
+      }
+  return set_field(pconfig->mpi_hints, sizeof(pconfig->mpi_hints), value);
+}
+
+static int apply_threads(configuration* pconfig, const char* value)
+{
+  int threads = atoi(value);
+  if (threads < 1)
+    return -1;
+  pconfig->threads_per_rank = (unsigned int)threads;
+  return 0;
+}
+
+/*
+ *
+ * Does an axis matter for a case? This may depend on the axes before it.
+ *
+ */
+
+static int is_chunked(const configuration* pconfig, int size)
+{
+  return strncmp(pconfig->layout, "chunked", 16) == 0;
+}
+
+/* the attributes are created synchronously, right after their dataset, and
+   the no-attributes hint is for datasets without attributes */
+
+static int creates_attributes(const configuration* pconfig, int size)
+{
+  return pconfig->async == 0;
+}
+
+static int has_attributes(const configuration* pconfig, int size)
+{
+  return pconfig->attributes > 0;
+}
+
+static int has_no_attributes(const configuration* pconfig, int size)
+{
+  return pconfig->attributes == 0;
+}
+
+/* the 4D chunks span the arrays of a step, which are written one by one, and
+   there is no asynchronous direct chunk write. The ranks encode whole chunks
+   of their block, so the chunks must tile it, and they can only run some of
+   the filters. (Whether the ranks share the file is up to case_possible,
+   the files axis comes later.) */
+
+static int writes_whole_chunks(const configuration* pconfig, int size)
+{
+  proc_grid w;
+  hsize_t crows, ccols;
+
+  if (!is_chunked(pconfig, size) || pconfig->rank > 3 || pconfig->async != 0)
+    return 0;
+  if (!pipeline_encodable(pconfig->filter) ||
+      chunk_shape(pconfig, &crows, &ccols) != 0)
+    return 0;
+  write_grid(pconfig, &w);
+  return w.my_rows%crows == 0 && w.my_cols%ccols == 0;
+}
+
+/* the column slabs of all readers of a shared file must tile its columns
+   (a group's file is read on the group's grid, where they always do) */
+
+static int slabs_tile(const configuration* pconfig, int size)
+{
+  proc_grid r;
+
+  if (strncmp(pconfig->read_pattern, "column-slab", 16) != 0 ||
+      file_groups(pconfig, size) != 1)
+    return 1;
+  read_grid(pconfig, &r);
+  return (r.proc_cols*r.my_cols)%(r.proc_rows*r.proc_cols) == 0;
+}
+
+/* paged aggregation doesn't work with the split driver, and the page
+   buffer needs paged aggregation and isn't available in parallel */
+
+static int pages_file_space(const configuration* pconfig, int size)
+{
+  return pconfig->split == 0;
+}
+
+static int has_page_buffer(const configuration* pconfig, int size)
+{
+  return pages_file_space(pconfig, size) && pconfig->fspace_page_size > 0 &&
+    size == 1 && strncmp(pconfig->single_process, "mpi-io-uni", 16) != 0;
+}
+
+/* the parallel library doesn't support evict on close, and doesn't write
+   cache images */
+
+static int can_evict_on_close(const configuration* pconfig, int size)
+{
+#ifdef H5_HAVE_PARALLEL
+  return 0;
+#else
+  return 1;
+#endif
+}
+
+static int can_write_mdc_image(const configuration* pconfig, int size)
+{
+  return size == 1 && strncmp(pconfig->single_process, "mpi-io-uni", 16) != 0;
+}
+
+/* only rank 2 and the rank 3 dataset per array have several datasets per step */
+
+static int has_datasets_per_step(const configuration* pconfig, int size)
+{
+  return pconfig->rank == 2 ||
+    (pconfig->rank == 3 &&
+     strncmp(pconfig->slowest_dimension, "array", 16) == 0);
+}
+
+/* the ranks can split into groups with a shared file each, unless they
+   already write files of their own (virtual layout) */
+
+static int splits_files(const configuration* pconfig, int size)
+{
+  return size > 1 && pconfig->split == 0 &&
+    strncmp(pconfig->layout, "virtual", 16) != 0;
+}
+
+/* subfiling replaces the MPI-IO VFD and doesn't stack with the split driver,
+   and with the virtual layout, the ranks write files of their own; it's set
+   up for all ranks, so there's a single shared file */
+
+static int uses_mpio_vfd(const configuration* pconfig, int size)
+{
+  return pconfig->split == 0 &&
+    strncmp(pconfig->layout, "virtual", 16) != 0 &&
+    pconfig->file_groups == 1 &&
+    (size > 1 || strncmp(pconfig->single_process, "mpi-io-uni", 16) == 0);
+}
+
+/* the split driver can't do collective I/O, and neither can the ranks on
+   their own files (virtual layout, or a file per rank) */
+
+static int is_parallel(const configuration* pconfig, int size)
+{
+  return splits_files(pconfig, size) && file_group_size(pconfig, size) > 1;
+}
+
+/* the hints are passed to the MPI-IO VFD (but not to subfiling) */
+
+static int takes_mpi_hints(const configuration* pconfig, int size)
+{
+  return pconfig->split == 0 && pconfig->subfiling == 0 &&
+    strncmp(pconfig->layout, "virtual", 16) != 0 &&
+    (size > 1 || strncmp(pconfig->single_process, "mpi-io-uni", 16) == 0);
+}
+
+/* The threads of a rank write different datasets of a step, one call per
+   dataset. Their calls can't be collective (they would be issued in a
+   different order on each rank), and the rank encodes direct chunk writes
+   on all threads anyway. */
+
+static int writes_in_threads(const configuration* pconfig, int size)
+{
+  return has_datasets_per_step(pconfig, size) && pconfig->multi_dataset == 0 &&
+    pconfig->async == 0 && strncmp(pconfig->chunk_write, "direct", 16) != 0 &&
+    strncmp(pconfig->mpi_io, "independent", 16) == 0;
+}
+
+typedef struct
+{
+  const char* name;      /* the ini key and the axis name in filters */
+  const char* defaults;  /* the values if the key is absent */
+  const char* baseline;  /* a single value runs after this one */
+  const char* off;       /* the value if the axis doesn't apply */
+  int (*apply)(configuration* pconfig, const char* value);
+  int (*applies)(const configuration* pconfig, int size);
+} axis_def;
+
+static const axis_def axis_defs[AXIS_COUNT] =
+  {
+    { "dataset-rank",      "2,3,4",              NULL,    NULL,
+      apply_rank,      NULL },
+    { "slowest-dimension", "step,array",         NULL,    NULL,
+      apply_slowdim,   NULL },
+    { "layout",            "contiguous,chunked", NULL,    NULL,
+      apply_layout,    NULL },
+    { "fill-values",       "true,false",         NULL,    NULL,
+      apply_fill,      NULL },
+    { "attributes",        "0",                  "0",     "0",
+      apply_attributes, creates_attributes },
+    { "attr-phase-change", "8:6",                "8:6",   "8:6",
+      apply_phase_change, has_attributes },
+    { "track-times",       "true",               "true",  NULL,
+      apply_track_times, NULL },
+    { "no-attrs-hint",     "false",              "false", "false",
+      apply_no_attrs_hint, has_no_attributes },
+    { "alignment",         NULL,                 "1:0",   NULL,
+      apply_alignment, NULL },
+    { "meta-block-size",   "2048",               "2048",  NULL,
+      apply_mblk,      NULL },
+    { "file-space-page-size", "0",               "0",     "0",
+      apply_page_size, pages_file_space },
+    { "page-buffer-size",  "0",                  "0",     "0",
+      apply_page_buffer, has_page_buffer },
+    { "mdc-config",        "default",            "default", NULL,
+      apply_mdc_config, NULL },
+    { "evict-on-close",    "false",              "false", "false",
+      apply_evict,     can_evict_on_close },
+    { "mdc-image",         "false",              "false", "false",
+      apply_mdc_image, can_write_mdc_image },
+    { "chunk-shape",       "block",              "block", NULL,
+      apply_shape,     is_chunked },
+    { "chunk-cache",       NULL,                 NULL,    NULL,
+      apply_cache,     is_chunked },
+    { "filter",            NULL,                 NULL,    "none",
+      apply_filter,    is_chunked },
+    { "chunk-write",       "library",            "library", "library",
+      apply_chunk_write, writes_whole_chunks },
+    { "libver-bound-low",  "earliest,latest",    NULL,    NULL,
+      apply_libver,    NULL },
+    { "files",             "shared",             "shared", "shared",
+      apply_files,     splits_files },
+    { "multi-dataset",     "false",              "false", "false",
+      apply_multi,     has_datasets_per_step },
+    { "subfiling",         "false",              "false", "false",
+      apply_subfiling, uses_mpio_vfd },
+    { "mpi-io",            "independent,collective", NULL, "independent",
+      apply_mpi_io,    is_parallel },
+    { "mpi-hints",         "none",               "none",  "none",
+      apply_mpi_hints, takes_mpi_hints },
+    { "threads-per-rank",  "1",                  "1",     "1",
+      apply_threads,   writes_in_threads },
+    { "read-pattern",      "replay",             "replay", NULL,
+      apply_read_pattern, NULL }
+  };
+
+int axis_find(const char* name)
+{
+  int a;
+  for (a = 0; a < AXIS_COUNT; ++a)
+    if (strcmp(name, axis_defs[a].name) == 0)
+      return a;
+  return -1;
+}
+
+/*
+ *
+ * The number of values in a list and the i-th value (without blanks).
+ * axis_value returns -1 (and the truncated value) for a value too long.
+ *
+ */
+
+static unsigned int axis_length(const char* list)
+{
+  unsigned int result = 1;
+  for (; *list != '\0'; ++list)
+    if (*list == ',')
+      ++result;
+  return result;
+}
+
+static int axis_value(const char* list, unsigned int i, char* value)
+{
+  size_t len;
+  int result = 0;
+
+  while (i > 0)
+    if (*list++ == ',')
+      --i;
+  list += strspn(list, " \t");
+  len = strcspn(list, ",");
+  while (len > 0 && (list[len - 1] == ' ' || list[len - 1] == '\t'))
+    --len;
+  if (len > AXIS_VALUE_LEN - 1)
+    {
+      len = AXIS_VALUE_LEN - 1;
+      result = -1;
+    }
+  memcpy(value, list, len);
+  value[len] = '\0';
+  return result;
+}
+
+/*
+ *
+ * Fill in the value lists not given in the ini file. The alignment and the
+ * raw data chunk cache lists are built from their individual settings, and a
+ * single value for an axis with a baseline is run after the baseline.
+ *
+ */
+
+void cases_init(configuration* pconfig)
+{
+  char buf[AXIS_VALUES_LEN];
+  char value[AXIS_VALUE_LEN];
+  size_t nslots, nbytes;
+  double w0;
+  hid_t fapl;
+  int a;
+
+  /* the library's default raw data chunk cache */
+  assert((fapl = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
+  assert(H5Pget_cache(fapl, NULL, &nslots, &nbytes, &w0) >= 0);
+  assert(H5Pclose(fapl) >= 0);
+
+  for (a = 0; a < AXIS_COUNT; ++a)
+    {
+      char* list = pconfig->axes[a];
+
+      if (list[0] != '\0')
+        {
+          if (axis_defs[a].baseline == NULL || axis_length(list) > 1)
+            continue;
+          axis_value(list, 0, value);
+          if (strcmp(value, axis_defs[a].baseline) != 0)
+            snprintf(buf, sizeof(buf), "%s,%s", axis_defs[a].baseline, value);
+          else
+            snprintf(buf, sizeof(buf), "%s", value);
+        }
+      else if (a == AXIS_ALIGNMENT)
+        {
+          if (pconfig->alignment_increment != 1 ||
+              pconfig->alignment_threshold != 0)
+            snprintf(buf, sizeof(buf), "1:0,%llu:%llu",
+                     (unsigned long long)pconfig->alignment_increment,
+                     (unsigned long long)pconfig->alignment_threshold);
+          else
+            snprintf(buf, sizeof(buf), "1:0");
+        }
+      else if (a == AXIS_CHUNK_CACHE)
+        {
+          if (pconfig->chunk_cache_nslots != nslots ||
+              pconfig->chunk_cache_nbytes != nbytes ||
+              pconfig->chunk_cache_w0 != w0)
+            snprintf(buf, sizeof(buf), "%llu:%llu:%g,%llu:%llu:%g",
+                     (unsigned long long)nslots, (unsigned long long)nbytes, w0,
+                     (unsigned long long)pconfig->chunk_cache_nslots,
+                     (unsigned long long)pconfig->chunk_cache_nbytes,
+                     pconfig->chunk_cache_w0);
+          else
+            snprintf(buf, sizeof(buf), "%llu:%llu:%g",
+                     (unsigned long long)nslots, (unsigned long long)nbytes, w0);
+        }
+      else if (a == AXIS_FILTER)
+        {
+          /* the gzip and szip keys compress all chunked datasets */
+          if (strncmp(pconfig->compress_type, "gzip", 16) == 0)
+            snprintf(buf, sizeof(buf), "gzip:%u", pconfig->compress_par[0]);
+          else if (strncmp(pconfig->compress_type, "szip", 16) == 0)
+            snprintf(buf, sizeof(buf), "szip:%u:%u", pconfig->compress_par[0],
+                     pconfig->compress_par[1]);
+          else
+            snprintf(buf, sizeof(buf), "none");
+        }
+      else
+        snprintf(buf, sizeof(buf), "%s", axis_defs[a].defaults);
+
+      memcpy(list, buf, sizeof(buf));
+    }
+}
+
+/*
+ *
+ * Does a case match a filter, i.e., all of its AXIS=VALUE[|VALUE...] terms?
+ * Returns -1 for an unknown axis.
+ *
+ */
+
+static int filter_match(const char* filter, char value[][AXIS_VALUE_LEN])
+{
+  char term[FILTER_LEN];
+  const char *p = filter, *alt;
+  char *eq;
+  size_t len, alen;
+  int a, match;
+
+  while (*(p += strspn(p, " \t")) != '\0')
+    {
+      len = strcspn(p, " \t");
+      memcpy(term, p, len);
+      term[len] = '\0';
+      p += len;
+
+      if ((eq = strchr(term, '=')) == NULL)
+        return -1;
+      *eq = '\0';
+      if ((a = axis_find(term)) < 0)
+        return -1;
+
+      match = 0;
+      for (alt = eq + 1; !match; alt += alen + 1)
+        {
+          alen = strcspn(alt, "|");
+          match = (alen == strlen(value[a]) && strncmp(alt, value[a], alen) == 0);
+          if (alt[alen] == '\0')
+            break;
+        }
+      if (!match)
+        return 0;
+    }
+
+  return 1;
+}
+
+static int case_selected(const configuration* pconfig,
+                         char value[][AXIS_VALUE_LEN])
+{
+  unsigned int i, include = (pconfig->n_include == 0);
+
+  for (i = 0; i < pconfig->n_include && !include; ++i)
+    include = (filter_match(pconfig->include[i], value) == 1);
+  for (i = 0; i < pconfig->n_exclude && include; ++i)
+    include = (filter_match(pconfig->exclude[i], value) != 1);
+
+  return include;
+}
+
+/*
+ *
+ * Check the value lists and filters. Returns -1 if something is off.
+ *
+ */
+
+int cases_check(const configuration* pconfig, int size)
+{
+  configuration* scratch;
+  char value[AXIS_COUNT][AXIS_VALUE_LEN];
+  unsigned int i, n;
+  int a, result = 0;
+
+  assert((scratch = (configuration*) malloc(sizeof(configuration))) != NULL);
+  memcpy(scratch, pconfig, sizeof(configuration));
+
+  for (a = 0; a < AXIS_COUNT; ++a)
+    {
+      n = axis_length(pconfig->axes[a]);
+      for (i = 0; i < n; ++i)
+        {
+          if (axis_value(pconfig->axes[a], i, value[a]) < 0 ||
+              axis_defs[a].apply(scratch, value[a]) < 0)
+            {
+              printf("Invalid %s value '%s'\n", axis_defs[a].name, value[a]);
+              result = -1;
+            }
+          /* with only a shared file, no column-slab case could run */
+          else if (a == AXIS_READ_PATTERN &&
+                   strcmp(pconfig->axes[AXIS_FILES], "shared") == 0)
+            {
+              scratch->file_groups = 1;
+              if (!slabs_tile(scratch, size))
+                {
+                  printf("Invalid %s value '%s' (the columns don't split "
+                         "evenly across the readers)\n", axis_defs[a].name,
+                         value[a]);
+                  result = -1;
+                }
+            }
+        }
+    }
+
+  for (a = 0; a < AXIS_COUNT; ++a)
+    value[a][0] = '\0';
+  for (i = 0; i < pconfig->n_include + pconfig->n_exclude; ++i)
+    {
+      const char* filter = (i < pconfig->n_include) ?
+        pconfig->include[i] : pconfig->exclude[i - pconfig->n_include];
+      if (filter_match(filter, value) < 0)
+        {
+          printf("Invalid filter '%s'\n", filter);
+          result = -1;
+        }
+    }
+
+  free(scratch);
+  return result;
+}
+
+/*
+ *
+ * Iterate over the selected cases. case_next sets the parameters of the next
+ * case in pconfig and returns 0 when there are no more cases.
+ *
+ */
+
+void case_begin(const configuration* pconfig, case_iter* it)
+{
+  int a;
+  for (a = 0; a < AXIS_COUNT; ++a)
+    {
+      it->count[a] = axis_length(pconfig->axes[a]);
+      it->index[a] = it->best[a] = 0;
+    }
+  it->started = 0;
+  it->best_time = -1.0;
+  it->axis = it->last_axis = -1;
+  it->improved = it->runs = 0;
+}
+
+static int case_advance(case_iter* it)
+{
+  int a;
+
+  if (!it->started)
+    {
+      it->started = 1;
+      return 1;
+    }
+
+  for (a = AXIS_COUNT - 1; a >= 0; --a)
+    {
+      if (++it->index[a] < it->count[a])
+        return 1;
+      it->index[a] = 0;
+    }
+
+  return 0;
+}
+
+/*
+ * A compact dataset's raw data is kept in its object header, which holds
+ * less than 64 KiB. In parallel, only one rank's copy of the header would
+ * end up in the file. The ranks must split evenly into the file groups, and
+ * the page buffer must hold at least a page. The column slabs must tile the
+ * columns of a shared file (see slabs_tile). A rank's H5Dwrite_chunk
+ * reallocates its chunks in the chunk index on its own, which isn't
+ * collective, so direct chunk writes need a file per rank.
+ */
+
+static int case_possible(const configuration* pconfig, int size)
+{
+  if (pconfig->page_buffer_size > 0 &&
+      pconfig->page_buffer_size < pconfig->fspace_page_size)
+    return 0;
+  if (!slabs_tile(pconfig, size))
+    return 0;
+  if (strncmp(pconfig->layout, "compact", 16) == 0)
+    return size == 1 && compact_fits(pconfig);
+  /* the groups of ranks must be the same size */
+  if (file_groups(pconfig, size) > (unsigned int)size ||
+      size % file_groups(pconfig, size) != 0)
+    return 0;
+  return strncmp(pconfig->chunk_write, "direct", 16) != 0 ||
+    file_group_size(pconfig, size) == 1;
+}
+
+/*
+ * An axis that doesn't apply to a case is run only once, with its "off" value
+ * (or its first value), and not for every value in its list. The tuner holds
+ * the axes other than the one it sweeps (strict) at their best values, which
+ * are reset to the first one where an axis stops applying. strict < 0 means
+ * all axes. applies (if not NULL) receives which axes apply.
+ */
+
+static int case_apply(configuration* pconfig, int size, unsigned int index[],
+                      int strict, char value[][AXIS_VALUE_LEN],
+                      unsigned int applies[])
+{
+  int a, on;
+
+  for (a = 0; a < AXIS_COUNT; ++a)
+    {
+      on = (axis_defs[a].applies == NULL || axis_defs[a].applies(pconfig, size));
+      if (applies != NULL)
+        applies[a] = (unsigned int) on;
+      if (!on)
+        {
+          if (index[a] != 0 && (strict < 0 || strict == a))
+            return 0;
+          index[a] = 0;
+          if (axis_defs[a].off != NULL)
+            snprintf(value[a], AXIS_VALUE_LEN, "%s", axis_defs[a].off);
+          else
+            axis_value(pconfig->axes[a], 0, value[a]);
+        }
+      else
+        axis_value(pconfig->axes[a], index[a], value[a]);
+
+      if (axis_defs[a].apply(pconfig, value[a]) < 0)
+        return 0;
+    }
+
+  return case_possible(pconfig, size);
+}
+
+static int matrix_next(configuration* pconfig, int size, case_iter* it)
+{
+  char value[AXIS_COUNT][AXIS_VALUE_LEN];
+
+  while (case_advance(it))
+    if (case_apply(pconfig, size, it->index, -1, value, NULL) &&
+        case_selected(pconfig, value))
+      return 1;
+
+  return 0;
+}
+
+/*
+ * The tuner's next combination: the next value of the axis being swept, or
+ * the first of the next axis with several values. Returns 0 when no axis is
+ * left that might improve on the best case.
+ */
+
+static int tune_advance(case_iter* it)
+{
+  int a = it->axis;
+
+  for (;;)
+    {
+      if (a >= 0)
+        while (++it->index[a] < it->count[a])
+          if (it->index[a] != it->best[a])
+            return 1;
+
+      if (a >= 0 && it->improved)
+        it->last_axis = a;
+      it->improved = 0;
+      do
+        if (++a == AXIS_COUNT)
+          {
+            if (it->last_axis < 0)
+              return 0; /* a full pass without any improvement */
+            a = 0;
+          }
+      while (it->count[a] < 2);
+      if (a == it->last_axis)
+        return 0; /* nothing has changed since this axis was swept */
+
+      it->axis = a;
+      memcpy(it->index, it->best, sizeof(it->index));
+      it->index[a] = 0;
+      if (it->best[a] != 0)
+        return 1;
+    }
+}
+
+int case_next(configuration* pconfig, int size, case_iter* it)
+{
+  char value[AXIS_COUNT][AXIS_VALUE_LEN];
+
+  /* the tuner starts from the first case */
+  if (strncmp(pconfig->tune, "none", 16) == 0 || it->runs == 0)
+    return matrix_next(pconfig, size, it);
+
+  if (pconfig->tune_budget > 0 && it->runs >= pconfig->tune_budget)
+    return 0;
+
+  while (tune_advance(it))
+    if (case_apply(pconfig, size, it->index, it->axis, value, NULL) &&
+        case_selected(pconfig, value))
+      return 1;
+
+  return 0;
+}
+
+/*
+ *
+ * Hand the time [s] of the case just run to the tuner
+ *
+ */
+
+void case_report(case_iter* it, double time)
+{
+  ++it->runs;
+  if (it->best_time < 0.0 || time < it->best_time)
+    {
+      memcpy(it->best, it->index, sizeof(it->best));
+      it->best_time = time;
+      it->improved = (it->axis >= 0);
+    }
+}
+
+/*
+ *
+ * Set the parameters of the tuner's best case in pconfig
+ *
+ */
+
+void case_best(configuration* pconfig, int size, const case_iter* it)
+{
+  char value[AXIS_COUNT][AXIS_VALUE_LEN];
+  unsigned int index[AXIS_COUNT];
+
+  memcpy(index, it->best, sizeof(index));
+  assert(case_apply(pconfig, size, index, -1, value, NULL));
+}
+
+/*
+ *
+ * Write an ini file that runs the tuner's best case: a copy of ini without
+ * the axes, filters, and tuner settings, followed by a single value for each
+ * axis. A single value of an axis with a baseline is run after the baseline
+ * (see cases_init), so an include filter pins those that differ from it. The
+ * results go to a CSV file of the same name (foo-tuned.ini -> foo-tuned.csv).
+ *
+ */
+
+static int ini_dropped(const char* name)
+{
+  static const char* const keys[] =
+    { "include", "exclude", "tune", "tune-budget", "restart", "one-case",
+      "csv-file", NULL };
+  unsigned int i;
+
+  if (axis_find(name) >= 0)
+    return 1;
+  for (i = 0; keys[i] != NULL; ++i)
+    if (strcmp(name, keys[i]) == 0)
+      return 1;
+  return 0;
+}
+
+void case_write_ini(const configuration* pconfig, int size,
+                    const case_iter* it, const char* ini, const char* fname)
+{
+  configuration* scratch;
+  char value[AXIS_COUNT][AXIS_VALUE_LEN];
+  unsigned int index[AXIS_COUNT], applies[AXIS_COUNT];
+  /* the include line must fit in an ini line */
+  char line[1024], name[64], include[INI_MAX_LINE - 16];
+  const char* key;
+  size_t len, pos = 0;
+  FILE *in, *out;
+  int a;
+
+  assert((scratch = (configuration*) malloc(sizeof(configuration))) != NULL);
+  memcpy(scratch, pconfig, sizeof(configuration));
+  memcpy(index, it->best, sizeof(index));
+  assert(case_apply(scratch, size, index, -1, value, applies));
+
+  assert((in = fopen(ini, "r")) != NULL);
+  assert((out = fopen(fname, "w")) != NULL);
+  while (fgets(line, sizeof(line), in) != NULL)
+    {
+      key = line + strspn(line, " \t");
+      len = strcspn(key, "=: \t\r\n");
+      if (*key != '#' && *key != ';' && *key != '[' && len > 0 &&
+          len < sizeof(name))
+        {
+          memcpy(name, key, len);
+          name[len] = '\0';
+          if (ini_dropped(name))
+            continue;
+        }
+      fputs(line, out);
+    }
+  fclose(in);
+
+  fprintf(out, "\n# the best of %u cases, %s phase %.4f s\n", it->runs,
+          pconfig->tune, it->best_time);
+  len = strlen(fname);
+  if (len >= 4 && strcmp(fname + len - 4, ".ini") == 0)
+    len -= 4;
+  fprintf(out, "csv-file = %.*s.csv\n", (int)len, fname);
+  include[0] = '\0';
+  for (a = 0; a < AXIS_COUNT; ++a)
+    {
+      fprintf(out, "%s = %s\n", axis_defs[a].name, value[a]);
+      if (applies[a] && axis_defs[a].baseline != NULL &&
+          strcmp(value[a], axis_defs[a].baseline) != 0 && pos < sizeof(include))
+        pos += (size_t)snprintf(include + pos, sizeof(include) - pos, "%s%s=%s",
+                                pos > 0 ? " " : "", axis_defs[a].name,
+                                value[a]);
+    }
+  if (pos >= sizeof(include))
+    printf("WARNING: the include filter of '%s' is too long\n", fname);
+  else if (pos > 0)
+    fprintf(out, "include = %s\n", include);
+  fclose(out);
+
+  free(scratch);
+}
+
+/*
+ *
+ * The number of selected cases and of all combinations
+ *
+ */
+
+unsigned int case_count(const configuration* pconfig, int size,
+                        unsigned int* combinations)
+{
+  configuration* scratch;
+  case_iter it;
+  unsigned int result = 0;
+  int a;
+
+  assert((scratch = (configuration*) malloc(sizeof(configuration))) != NULL);
+  memcpy(scratch, pconfig, sizeof(configuration));
+
+  case_begin(scratch, &it);
+  *combinations = 1;
+  for (a = 0; a < AXIS_COUNT; ++a)
+    *combinations *= it.count[a];
+
+  while (matrix_next(scratch, size, &it))
+    ++result;
+
+  free(scratch);
+  return result;
+}
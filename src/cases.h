@@ -0,0 +1,68 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#ifndef CASES_H
+#define CASES_H
+
+#include "configuration.h"
+
+/*
+ * The case matrix is the Cartesian product of the value lists of the axes
+ * (see axis_id, the last axis varies fastest). The value lists are kept as
+ * comma-separated strings in the configuration, so that the configuration can
+ * still be broadcast as a flat structure. A case runs if it matches one of the
+ * include filters (if any) and none of the exclude filters.
+ *
+ * With a tune objective, the cases are instead chosen by coordinate descent:
+ * starting from the first case, each axis in turn is swept over its values
+ * with the others held at the best case so far, until a full pass over the
+ * axes brings no improvement or the budget is spent. The time of each case
+ * is handed back via case_report.
+ */
+
+typedef struct
+{
+  unsigned int count[AXIS_COUNT];   /* number of values per axis */
+  unsigned int index[AXIS_COUNT];   /* the current combination */
+  unsigned int started;
+  /* the tuner */
+  unsigned int best[AXIS_COUNT];    /* the best combination so far */
+  double best_time;                 /* its time [s], < 0 if none yet */
+  int axis;                         /* the axis being swept */
+  int last_axis;                    /* the last sweep that improved */
+  unsigned int improved;            /* the current sweep improved */
+  unsigned int runs;                /* the cases run so far */
+} case_iter;
+
+extern int axis_find(const char* name);
+
+extern void cases_init(configuration* pconfig);
+
+extern int cases_check(const configuration* pconfig, int size);
+
+extern void case_begin(const configuration* pconfig, case_iter* it);
+
+extern int case_next(configuration* pconfig, int size, case_iter* it);
+
+extern unsigned int case_count(const configuration* pconfig, int size,
+                               unsigned int* combinations);
+
+extern void case_report(case_iter* it, double time);
+
+extern void case_best(configuration* pconfig, int size, const case_iter* it);
+
+extern void case_write_ini(const configuration* pconfig, int size,
+                           const case_iter* it, const char* ini,
+                           const char* fname);
+
+#endif
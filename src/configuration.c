@@ -13,6 +13,11 @@
 
 #include "configuration.h"
 
+#include "cases.h"
+#include "dataset.h"
+#include "generator.h"
+#include "pipeline.h"
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -75,6 +80,73 @@ parse_time(const char *str_in, duration *time)
     return 0;
 }
 
+/* A byte count with an optional binary suffix, e.g., 4096, 64K, 1M, or 2G */
+
+int
+parse_size(const char *str_in, unsigned long long *size)
+{
+    char *endptr;
+    *size = strtoull(str_in, &endptr, 10);
+    if (endptr == str_in)
+        return -1;
+    while (*endptr == ' ')
+        ++endptr;
+    switch (*endptr) {
+        case '\0':
+            break;
+        case 'k': case 'K':
+            *size <<= 10;
+            break;
+        case 'm': case 'M':
+            *size <<= 20;
+            break;
+        case 'g': case 'G':
+            *size <<= 30;
+            break;
+        default:
+            return -1;
+    }
+    return 0;
+}
+
+/* A metadata cache configuration INIT:MIN:MAX[:FLASH], e.g., 2M:1M:32M:1.4
+   (FLASH is the flash increment multiple, 0 or omitted = off) */
+
+int
+parse_mdc_config(const char *str_in, size_t *init, size_t *min, size_t *max,
+                 double *flash)
+{
+    char buf[AXIS_VALUE_LEN];
+    char *field[4], *sep, *endptr;
+    unsigned long long size[3];
+    unsigned int n = 1, i;
+
+    strncpy(buf, str_in, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    field[0] = buf;
+    while (n < 4 && (sep = strchr(field[n - 1], ':')) != NULL) {
+        *sep = '\0';
+        field[n++] = sep + 1;
+    }
+    if (n < 3 || strchr(field[n - 1], ':') != NULL)
+        return -1;
+
+    for (i = 0; i < 3; ++i)
+        if (parse_size(field[i], &size[i]) < 0)
+            return -1;
+    *init = (size_t) size[0];
+    *min = (size_t) size[1];
+    *max = (size_t) size[2];
+
+    *flash = 0.0;
+    if (n == 4) {
+        *flash = strtod(field[3], &endptr);
+        if (endptr == field[3] || *endptr != '\0')
+            return -1;
+    }
+    return 0;
+}
+
 int check_options
 (
  configuration* pconfig,
@@ -99,28 +171,20 @@ int check_options
     pconfig->proc_cols = (unsigned int) atoi(value);
   } else if (MATCH(section, "scaling")) {
     strncpy(pconfig->scaling, value, 15);
-  } else if (MATCH(section, "dataset-rank")) {
-    pconfig->rank = (unsigned int) atoi(value);
-  } else if (MATCH(section, "slowest-dimension")) {
-    strncpy(pconfig->slowest_dimension, value, 15);
-  } else if (MATCH(section, "libver-bound-low")) {
-    strncpy(pconfig->libver_bound_low, value, 15);
   } else if (MATCH(section, "libver-bound-high")) {
     strncpy(pconfig->libver_bound_high, value, 15);
   } else if (MATCH(section, "alignment-increment")) {
     pconfig->alignment_increment = (hsize_t) atol(value);
   } else if (MATCH(section, "alignment-threshold")) {
     pconfig->alignment_threshold = (hsize_t) atol(value);
-  } else if (MATCH(section, "meta-block-size")) {
-    pconfig->meta_block_size = (hsize_t) atol(value);
-  } else if (MATCH(section, "layout")) {
-    strncpy(pconfig->layout, value, 15);
-  } else if (MATCH(section, "fill-values")) {
-    strncpy(pconfig->fill_values, value, 7);
+  } else if (MATCH(section, "chunk-cache-nslots")) {
+    pconfig->chunk_cache_nslots = (size_t) atol(value);
+  } else if (MATCH(section, "chunk-cache-nbytes")) {
+    pconfig->chunk_cache_nbytes = (size_t) atol(value);
+  } else if (MATCH(section, "chunk-cache-w0")) {
+    pconfig->chunk_cache_w0 = atof(value);
   } else if (MATCH(section, "single-process")) {
     strncpy(pconfig->single_process, value, 15);
-  } else if (MATCH(section, "mpi-io")) {
-    strncpy(pconfig->mpi_io, value, 15);
   } else if (MATCH(section, "split")) {
     pconfig->split = (unsigned int) atol(value);
   } else if (MATCH(section, "hdf5-file")) {
@@ -140,6 +204,37 @@ int check_options
       return 0;
 #endif
       pconfig->async = (unsigned int) atol(value);
+  } else if (MATCH(section, "async-buffers")) {
+    pconfig->async_buffers = (unsigned int) atol(value);
+  } else if (MATCH(section, "multi-dataset")) {
+#if !H5_VERSION_GE(1,14,0)
+      printf("Multi-dataset I/O only supported for HDF5 version >= 1.14 \n");
+      return 0;
+#endif
+      strncpy(pconfig->axes[AXIS_MULTI], value, AXIS_VALUES_LEN-1);
+  } else if (MATCH(section, "subfiling")) {
+#if !H5_VERSION_GE(1,14,0) || !defined(H5_HAVE_SUBFILING_VFD)
+      printf("Subfiling requires HDF5 version >= 1.14 built with the subfiling VFD \n");
+      return 0;
+#endif
+      strncpy(pconfig->axes[AXIS_SUBFILING], value, AXIS_VALUES_LEN-1);
+  } else if (MATCH(section, "subfiling-stripe-size")) {
+    unsigned long long size;
+    if (parse_size(value, &size) < 0)
+      return 0;
+    pconfig->subfiling_stripe_size = (size_t)size;
+  } else if (MATCH(section, "subfiling-ioc-per-node")) {
+    pconfig->subfiling_ioc_per_node = (unsigned int) atol(value);
+  } else if (axis_find(name) >= 0) { /* a list of values of a case axis */
+    strncpy(pconfig->axes[axis_find(name)], value, AXIS_VALUES_LEN-1);
+  } else if (MATCH(section, "include")) {
+    if (pconfig->n_include == MAX_FILTERS)
+      return 0;
+    strncpy(pconfig->include[pconfig->n_include++], value, FILTER_LEN-1);
+  } else if (MATCH(section, "exclude")) {
+    if (pconfig->n_exclude == MAX_FILTERS)
+      return 0;
+    strncpy(pconfig->exclude[pconfig->n_exclude++], value, FILTER_LEN-1);
   } else if (MATCH(section, "delay")) {
     duration time;
     if (parse_time(value, &time) < 0)
@@ -150,8 +245,36 @@ int check_options
       printf("emulated compute phase time must be at least 0.\n");
       return 0;
     }
+  } else if (MATCH(section, "read-process-rows")) {
+    pconfig->read_proc_rows = (unsigned int) atol(value);
+  } else if (MATCH(section, "read-process-columns")) {
+    pconfig->read_proc_cols = (unsigned int) atol(value);
+  } else if (MATCH(section, "read-stride")) {
+    pconfig->read_stride = (unsigned int) atol(value);
+  } else if (MATCH(section, "repetitions")) {
+    pconfig->repetitions = (unsigned int) atol(value);
+  } else if (MATCH(section, "warmup")) {
+    pconfig->warmup = (unsigned int) atol(value);
+  } else if (MATCH(section, "ci-target")) {
+    pconfig->ci_target = atof(value);
+  } else if (MATCH(section, "tune")) {
+    strncpy(pconfig->tune, value, sizeof(pconfig->tune) - 1);
+  } else if (MATCH(section, "tune-budget")) {
+    pconfig->tune_budget = (unsigned int) atol(value);
   } else if (MATCH(section, "one-case")) {
     pconfig->one_case = (unsigned int) atol(value);
+  } else if (MATCH(section, "data-generator")) {
+    strncpy(pconfig->data_generator, value, sizeof(pconfig->data_generator) - 1);
+  } else if (MATCH(section, "data-entropy-bits")) {
+    pconfig->data_entropy_bits = (unsigned int) atol(value);
+  } else if (MATCH(section, "data-seed")) {
+    pconfig->data_seed = strtoull(value, NULL, 0);
+  } else if (MATCH(section, "data-file")) {
+    strncpy(pconfig->data_file, value, PATH_MAX);
+  } else if (MATCH(section, "data-dataset")) {
+    strncpy(pconfig->data_dataset, value, sizeof(pconfig->data_dataset) - 1);
+  } else if (MATCH(section, "plugin-path")) {
+    strncpy(pconfig->plugin_path, value, PATH_MAX);
   } else if (MATCH(section, "gzip")) {
     strncpy(pconfig->compress_type, "gzip", 15);
     pconfig->compress_par[0] = (unsigned int) atol(value);
@@ -214,9 +337,6 @@ int handler(void* user,
 
 int validate(configuration* pconfig, const int size)
 {
-  htri_t avail;
-  herr_t status;
-  unsigned int filter_info;
 
   assert(pconfig->version == 0);
   assert(pconfig->steps > 0);
@@ -238,6 +358,29 @@ int validate(configuration* pconfig, const int size)
 
   assert(pconfig->alignment_increment >= 1);
 
+  {
+    hsize_t crows, ccols;
+    assert(chunk_shape(pconfig, &crows, &ccols) == 0);
+  }
+
+  assert(pconfig->chunk_cache_nslots >= 1);
+  assert(pconfig->chunk_cache_w0 >= 0.0 && pconfig->chunk_cache_w0 <= 1.0);
+  assert(pconfig->async_buffers >= 1);
+  assert(pconfig->repetitions >= 1);
+  assert(pconfig->ci_target >= 0.0);
+  assert(pconfig->read_stride >= 1);
+  assert(generator_check(pconfig) == 0);
+
+  /* the read grid uses at most all ranks, and its blocks tile the array */
+  {
+    proc_grid w, r;
+    write_grid(pconfig, &w);
+    read_grid(pconfig, &r);
+    assert(r.proc_rows*r.proc_cols <= (unsigned)size);
+    assert((w.proc_rows*w.my_rows)%r.proc_rows == 0);
+    assert((w.proc_cols*w.my_cols)%r.proc_cols == 0);
+  }
+
   assert(strncmp(pconfig->single_process, "posix", 16) == 0 ||
          strncmp(pconfig->single_process, "core", 16) == 0  ||
          strncmp(pconfig->single_process, "mpi-io-uni", 16) == 0);
@@ -246,27 +389,16 @@ int validate(configuration* pconfig, const int size)
   assert(pconfig->split == 0 || pconfig->split == 1);
   assert(pconfig->one_case >= 0);
 
+  /* the tuner picks the cases itself */
+  assert(strncmp(pconfig->tune, "none", 16) == 0 ||
+         strncmp(pconfig->tune, "write", 16) == 0 ||
+         strncmp(pconfig->tune, "read", 16) == 0);
+  if (strncmp(pconfig->tune, "none", 16) != 0)
+    assert(pconfig->restart == 0 && pconfig->one_case == 0);
 
-  if (strncmp(pconfig->compress_type, "gzip", 16) == 0) {
-    /* check if gzip compression is available */
-    avail = H5Zfilter_avail(H5Z_FILTER_DEFLATE);
-    assert(avail > 0 );
-
-    status = H5Zget_filter_info (H5Z_FILTER_DEFLATE, &filter_info);
-    assert(status >= 0);
-    assert( (filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED) ||
-            (filter_info & H5Z_FILTER_CONFIG_DECODE_ENABLED) );
-  } else if (strncmp(pconfig->compress_type, "szip", 16) == 0) {
-    /* check if szip compression is available */
-    avail = H5Zfilter_avail(H5Z_FILTER_SZIP);
-    assert(avail > 0 );
 
-    status = H5Zget_filter_info (H5Z_FILTER_SZIP, &filter_info);
-    assert(status >= 0);
-
-    assert( (filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED) ||
-            (filter_info & H5Z_FILTER_CONFIG_DECODE_ENABLED) );
-  }
+  /* check if the filters are available */
+  assert(pipeline_check(pconfig->filter) == 0);
 
   return 0;
 }
@@ -34,6 +34,44 @@ typedef struct duration {
     time_unit     unit;
 } duration;
 
+/* The axes of the case matrix (see cases.h), outermost first */
+
+typedef enum axis_id {
+    AXIS_RANK,
+    AXIS_SLOWDIM,
+    AXIS_LAYOUT,
+    AXIS_FILL,
+    AXIS_ATTRIBUTES,
+    AXIS_ATTR_PHASE_CHANGE,
+    AXIS_TRACK_TIMES,
+    AXIS_NO_ATTRS_HINT,
+    AXIS_ALIGNMENT,
+    AXIS_META_BLOCK,
+    AXIS_PAGE_SIZE,
+    AXIS_PAGE_BUFFER,
+    AXIS_MDC_CONFIG,
+    AXIS_EVICT_ON_CLOSE,
+    AXIS_MDC_IMAGE,
+    AXIS_CHUNK_SHAPE,
+    AXIS_CHUNK_CACHE,
+    AXIS_FILTER,
+    AXIS_CHUNK_WRITE,
+    AXIS_LIBVER,
+    AXIS_FILES,
+    AXIS_MULTI,
+    AXIS_SUBFILING,
+    AXIS_MPI_IO,
+    AXIS_MPI_HINTS,
+    AXIS_THREADS,
+    AXIS_READ_PATTERN,
+    AXIS_COUNT
+} axis_id;
+
+#define AXIS_VALUES_LEN 256 /* a comma-separated list of values */
+#define AXIS_VALUE_LEN  128
+#define MAX_FILTERS     8
+#define FILTER_LEN      256
+
 /* Configuration parameters */
 
 typedef struct
@@ -53,10 +91,30 @@ typedef struct
   hsize_t       alignment_increment;
   hsize_t       alignment_threshold;
   hsize_t       meta_block_size;
+  hsize_t       fspace_page_size;  /* 0 = no paged aggregation */
+  size_t        page_buffer_size;  /* 0 = no page buffer */
+  char          mdc_config[AXIS_VALUE_LEN];  /* default or INIT:MIN:MAX[:FLASH] */
+  unsigned int  evict_on_close;
+  unsigned int  mdc_image;
+  size_t        chunk_cache_nslots;
+  size_t        chunk_cache_nbytes;
+  double        chunk_cache_w0;
   char          layout[16];
+  char          chunk_shape[32];
   char          fill_values[8];
+  unsigned int  attributes;       /* per dataset */
+  size_t        attribute_size;   /* [B] */
+  unsigned int  attr_max_compact; /* the attribute phase change */
+  unsigned int  attr_min_dense;
+  unsigned int  track_times;
+  unsigned int  no_attrs_hint;
   char          single_process[16];
   char          mpi_io[16];
+  char          mpi_hints[AXIS_VALUE_LEN];  /* none or KEY=VALUE[+...] */
+  char          read_pattern[16];
+  unsigned int  read_stride;
+  unsigned int  read_proc_rows;  /* 0 = the writer's grid */
+  unsigned int  read_proc_cols;
   char          hdf5_file[PATH_MAX+1];
   char          csv_file[PATH_MAX+1];
   unsigned int  restart;
@@ -65,8 +123,33 @@ typedef struct
   unsigned int  HDF5perCase;
   char          compress_type[16];
   unsigned int  compress_par[2];
+  char          filter[AXIS_VALUE_LEN];  /* the filter pipeline */
+  char          plugin_path[PATH_MAX+1];
+  char          chunk_write[16];  /* library or direct */
+  char          data_generator[16];  /* empty = by compression */
+  unsigned int  data_entropy_bits;
+  unsigned long long data_seed;
+  char          data_file[PATH_MAX+1];
+  char          data_dataset[256];
   unsigned int  async;
+  unsigned int  async_buffers;
+  unsigned int  file_groups;  /* the number of files, 1 = shared, 0 = per rank */
+  unsigned int  multi_dataset;
+  unsigned int  threads_per_rank;  /* writing the arrays of a step */
+  unsigned int  subfiling;
+  size_t        subfiling_stripe_size;
+  unsigned int  subfiling_ioc_per_node;
   duration      delay;
+  unsigned int  repetitions;
+  unsigned int  warmup;
+  double        ci_target;      /* [%] stop when the 95% CI is this tight */
+  char          tune[16];       /* none, write, or read (see case_report) */
+  unsigned int  tune_budget;    /* cases to run, 0 = until converged */
+  char          axes[AXIS_COUNT][AXIS_VALUES_LEN];
+  unsigned int  n_include;
+  unsigned int  n_exclude;
+  char          include[MAX_FILTERS][FILTER_LEN];
+  char          exclude[MAX_FILTERS][FILTER_LEN];
 } configuration;
 
 extern int handler(void* user,
@@ -76,4 +159,9 @@ extern int handler(void* user,
 
 extern int validate(configuration* user, const int size);
 
+extern int parse_size(const char *str_in, unsigned long long *size);
+
+extern int parse_mdc_config(const char *str_in, size_t *init, size_t *min,
+                            size_t *max, double *flash);
+
 #endif
@@ -12,25 +12,37 @@
 */
 
 #include "dataset.h"
+#include "pipeline.h"
 
 #include <assert.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /*
  *
- * Initialize the dataset creation property list.
+ * The rows and columns of a chunk for the configured chunk shape:
+ *
+ *   block      the rank's partition (default)
+ *   scale:RxC  R (C) times the rows (columns) of the rank's partition,
+ *              e.g., scale:2x2 spans the partitions of four ranks
+ *   dims:RxC   R rows and C columns
+ *   bytes:N    about N bytes (suffixes K, M, G) with the aspect ratio of the
+ *              rank's partition, including the array dimension for rank 4
+ *
+ * The result is clamped to the extent of the dataset. Returns -1 for an
+ * invalid shape.
  *
  */
 
-hid_t create_dcpl(const configuration* config, unsigned int coll_mpi_io_flg)
+int chunk_shape(const configuration* config, hsize_t* crows, hsize_t* ccols)
 {
-  hid_t result;
-  unsigned int strong_scaling_flg, step_first_flg, chunked_flg;
+  unsigned int strong_scaling_flg;
   unsigned long total_rows, total_cols, my_rows, my_cols;
-  hsize_t cdims[H5S_MAX_RANK];
-
-  assert((result = H5Pcreate(H5P_DATASET_CREATE)) >= 0);
+  unsigned long long r, c, nbytes;
+  double fr, fc, lead, scale;
+  const char* shape = config->chunk_shape;
 
   strong_scaling_flg = (strncmp(config->scaling, "strong", 16) == 0);
   total_rows = strong_scaling_flg ?
@@ -40,54 +52,157 @@ hid_t create_dcpl(const configuration* config, unsigned int coll_mpi_io_flg)
   my_rows = strong_scaling_flg ? config->rows/config->proc_rows : config->rows;
   my_cols = strong_scaling_flg ? config->cols/config->proc_cols : config->cols;
 
+  if (shape[0] == '\0' || strncmp(shape, "block", 32) == 0)
+    {
+      r = my_rows;
+      c = my_cols;
+    }
+  else if (strncmp(shape, "scale:", 6) == 0)
+    {
+      if (sscanf(shape + 6, "%lfx%lf", &fr, &fc) != 2 || fr <= 0.0 || fc <= 0.0)
+        return -1;
+      r = (unsigned long long)(fr*(double)my_rows + 0.5);
+      c = (unsigned long long)(fc*(double)my_cols + 0.5);
+    }
+  else if (strncmp(shape, "dims:", 5) == 0)
+    {
+      if (sscanf(shape + 5, "%llux%llu", &r, &c) != 2)
+        return -1;
+    }
+  else if (strncmp(shape, "bytes:", 6) == 0)
+    {
+      if (parse_size(shape + 6, &nbytes) < 0 || nbytes == 0)
+        return -1;
+      lead = (config->rank == 4) ? (double)config->arrays : 1.0;
+      scale = sqrt((double)nbytes/(sizeof(double)*lead*(double)my_rows*(double)my_cols));
+      r = (unsigned long long)(scale*(double)my_rows + 0.5);
+      if (r < 1)
+        r = 1;
+      c = (unsigned long long)((double)nbytes/(sizeof(double)*lead*(double)r) + 0.5);
+    }
+  else
+    return -1;
+
+  *crows = (hsize_t)(r < 1 ? 1 : (r > total_rows ? total_rows : r));
+  *ccols = (hsize_t)(c < 1 ? 1 : (c > total_cols ? total_cols : c));
+
+  return 0;
+}
+
+/*
+ *
+ * The chunk dimensions for the current configuration
+ *
+ */
+
+void chunk_dims(const configuration* config, hsize_t cdims[])
+{
+  unsigned int step_first_flg;
+  hsize_t crows, ccols;
+
+  assert(chunk_shape(config, &crows, &ccols) == 0);
+
   step_first_flg = (strncmp(config->slowest_dimension, "step", 16) == 0);
-  chunked_flg = (strncmp(config->layout, "chunked", 16) == 0);
 
-  if (chunked_flg)
+  switch (config->rank)
     {
-      switch (config->rank)
+    case 2:
+      cdims[0] = crows;
+      cdims[1] = ccols;
+      break;
+    case 3:
+      cdims[0] = 1;
+      cdims[1] = crows;
+      cdims[2] = ccols;
+      break;
+    case 4:
+      if (step_first_flg)
         {
-        case 2:
-          cdims[0] = (hsize_t)my_rows;
-          cdims[1] = (hsize_t)my_cols;
-          break;
-        case 3:
           cdims[0] = 1;
-          cdims[1] = (hsize_t)my_rows;
-          cdims[2] = (hsize_t)my_cols;
-          break;
-        case 4:
-          if (step_first_flg)
-            {
-              cdims[0] = 1;
-              cdims[1] = (hsize_t)config->arrays;
-            }
-          else
-            {
-              cdims[0] = (hsize_t)config->arrays;
-              cdims[1] = 1;
-            }
-          cdims[2] = (hsize_t)my_rows;
-          cdims[3] = (hsize_t)my_cols;
-          break;
-        default:
-          break;
+          cdims[1] = (hsize_t)config->arrays;
         }
+      else
+        {
+          cdims[0] = (hsize_t)config->arrays;
+          cdims[1] = 1;
+        }
+      cdims[2] = crows;
+      cdims[3] = ccols;
+      break;
+    default:
+      break;
+    }
+}
+
+/*
+ *
+ * Does the filter pipeline apply to the datasets of the current case?
+ * Parallel compression only works with collective I/O, unless the ranks
+ * encode the chunks themselves (direct chunk writes).
+ *
+ */
+
+int filtered(const configuration* config, unsigned int coll_mpi_io_flg)
+{
+  return strncmp(config->layout, "chunked", 16) == 0 &&
+    strcmp(config->filter, "none") != 0 &&
+    (config->proc_rows*config->proc_cols == 1 || coll_mpi_io_flg == 1 ||
+     strncmp(config->chunk_write, "direct", 16) == 0);
+}
+
+/*
+ *
+ * The chunks of a rank's source dataset with the virtual layout (see
+ * create_virtual_dataset)
+ *
+ */
+
+static void source_chunk_dims(const configuration* config, hsize_t cdims[])
+{
+  proc_grid grid;
+  unsigned int i, lead;
+
+  write_grid(config, &grid);
+  lead = config->rank - 2;
+  for (i = 0; i < lead; ++i)
+    cdims[i] = 1;
+  cdims[lead] = (hsize_t)grid.my_rows;
+  cdims[lead + 1] = (hsize_t)grid.my_cols;
+}
+
+/*
+ *
+ * Initialize the dataset creation property list.
+ *
+ */
+
+hid_t create_dcpl(const configuration* config, unsigned int coll_mpi_io_flg)
+{
+  hid_t result;
+  unsigned int chunked_flg;
+  hsize_t cdims[H5S_MAX_RANK];
 
+  assert((result = H5Pcreate(H5P_DATASET_CREATE)) >= 0);
+
+  chunked_flg = (strncmp(config->layout, "chunked", 16) == 0);
+
+  if (chunked_flg)
+    {
+      chunk_dims(config, cdims);
       assert(H5Pset_chunk(result, config->rank, cdims) >= 0);
 
-      /* apply compression:
-       * parallel compression only works for collective
-       */
-      if( config->proc_rows*config->proc_cols == 1  ||  coll_mpi_io_flg == 1) {
-        if (strncmp(config->compress_type, "gzip", 16) == 0) {
-          assert( H5Pset_deflate(result, config->compress_par[0]) >= 0);
-        } else if (strncmp(config->compress_type, "szip", 16) == 0) {
-          assert( H5Pset_szip(result, config->compress_par[0], config->compress_par[1]) >= 0);
-        }
-      }
+      if (filtered(config, coll_mpi_io_flg))
+        pipeline_apply(config->filter, result);
 
     }
+  else if (strncmp(config->layout, "compact", 16) == 0)
+    assert(H5Pset_layout(result, H5D_COMPACT) >= 0);
+  else if (strncmp(config->layout, "virtual", 16) == 0)
+    {
+      /* a rank's source dataset (see source_chunk_dims) */
+      source_chunk_dims(config, cdims);
+      assert(H5Pset_chunk(result, config->rank, cdims) >= 0);
+    }
   else
     assert(H5Pset_layout(result, H5D_CONTIGUOUS) >= 0);
 
@@ -96,6 +211,15 @@ hid_t create_dcpl(const configuration* config, unsigned int coll_mpi_io_flg)
   else
     assert(H5Pset_fill_time(result, H5D_FILL_TIME_ALLOC) >= 0);
 
+  /* the object header */
+  assert(H5Pset_attr_phase_change(result, config->attr_max_compact,
+                                  config->attr_min_dense) >= 0);
+  assert(H5Pset_obj_track_times(result, (hbool_t)config->track_times) >= 0);
+#if H5_VERSION_GE(1,10,5)
+  assert(H5Pset_dset_no_attrs_hint(result, (hbool_t)config->no_attrs_hint)
+         >= 0);
+#endif
+
   return result;
 }
 
@@ -164,6 +288,90 @@ static hid_t create_fspace(const configuration* config)
   return result;
 }
 
+/*
+ *
+ * Does a dataset fit into its object header (compact layout)? The raw data
+ * message must stay below 64 KiB, including its own header.
+ *
+ */
+
+#define COMPACT_MAX_BYTES 65520
+
+int compact_fits(const configuration* config)
+{
+  hid_t fspace;
+  hssize_t npoints;
+
+  assert((fspace = create_fspace(config)) >= 0);
+  assert((npoints = H5Sget_simple_extent_npoints(fspace)) >= 0);
+  assert(H5Sclose(fspace) >= 0);
+
+  return (unsigned long long)npoints*sizeof(double) <= COMPACT_MAX_BYTES;
+}
+
+/*
+ *
+ * The number of objects (groups, datasets, and attributes) a rank creates
+ * in the write phase. The datasets of rank 2 sit in a group per step (or
+ * array), and those of rank 3 directly in the root group.
+ *
+ */
+
+unsigned long long objects_created(const configuration* config)
+{
+  unsigned int step_first_flg;
+  unsigned long long groups = 0, datasets = 1;
+
+  step_first_flg = (strncmp(config->slowest_dimension, "step", 16) == 0);
+
+  switch (config->rank)
+    {
+    case 2:
+      groups = step_first_flg ? config->steps : config->arrays;
+      datasets = (unsigned long long)config->steps*config->arrays;
+      break;
+    case 3:
+      datasets = step_first_flg ? config->steps : config->arrays;
+      break;
+    default:
+      break;
+    }
+
+  return groups + datasets*(1 + config->attributes);
+}
+
+/*
+ *
+ * Attach the configured number of attributes to a new dataset
+ *
+ */
+
+static void create_attributes(const configuration* config, hid_t dset)
+{
+  hid_t space, attr;
+  hsize_t dims[1];
+  unsigned char* buf;
+  unsigned int i;
+  char name[32];
+
+  dims[0] = (hsize_t)config->attribute_size;
+  assert((space = H5Screate_simple(1, dims, NULL)) >= 0);
+  assert((buf = (unsigned char*) malloc(config->attribute_size)) != NULL);
+
+  for (i = 0; i < config->attributes; ++i)
+    {
+      memset(buf, (int)(i & 0xff), config->attribute_size);
+      sprintf(name, "attribute=%u", i);
+      assert((attr = H5Acreate(dset, name, H5T_NATIVE_UCHAR, space,
+                               H5P_DEFAULT, H5P_DEFAULT)) >= 0);
+      assert(H5Awrite(attr, H5T_NATIVE_UCHAR, buf) >= 0);
+      assert(H5Aclose(attr) >= 0);
+    }
+
+  free(buf);
+  assert(H5Sclose(space) >= 0);
+}
+
 /*
  *
  * Create an anonymous dataset for the current configuration
@@ -187,6 +395,9 @@ hid_t create_dataset(const configuration* config, hid_t file, const char* name,
     assert((result = H5Dcreate(file, name, H5T_NATIVE_DOUBLE, fspace,
                                lcpl, dcpl, dapl)) >= 0);
 
+  if (config->attributes > 0)
+    create_attributes(config, result);
+
   assert(H5Sclose(fspace) >= 0);
   assert(H5Pclose(dcpl) >= 0);
   return result;
@@ -195,69 +406,305 @@ hid_t create_dataset(const configuration* config, hid_t file, const char* name,
 
 /*
  *
- * Create an in-file dataspace selection depending on the step and variable
+ * The virtual layout: each rank writes its block to a source file of its
+ * own (foo-src<RANK>.h5 for foo.h5), and a virtual dataset in the main file
+ * maps the blocks into the global array. A source dataset has the extent of
+ * the global array, but its only chunk is the rank's block, so that it
+ * stores just that block and the ranks run the same write code as for a
+ * shared file.
+ *
+ */
+
+void source_file_name(const char* fname, int rank, char* sname, size_t len)
+{
+  size_t n = strlen(fname);
+
+  if (n >= 3 && strcmp(fname + n - 3, ".h5") == 0)
+    n -= 3;
+  snprintf(sname, len, "%.*s-src%d.h5", (int)n, fname, rank);
+}
+
+/*
+ *
+ * With a file per group of ranks (files = per-rank or per-group:G), the
+ * ranks are split into file_groups() groups of consecutive ranks, and each
+ * group writes and reads the file foo-grp<GROUP>.h5 for foo.h5 as if it were
+ * the whole run. The part of a group is its ranks' blocks side by side, as
+ * in a process grid of 1 x (ranks per group) (see group_config).
+ *
+ */
+
+unsigned int file_groups(const configuration* config, int size)
+{
+  return config->file_groups == 0 ? (unsigned int)size : config->file_groups;
+}
+
+unsigned int file_group_size(const configuration* config, int size)
+{
+  return (unsigned int)size/file_groups(config, size);
+}
+
+void group_file_name(const char* fname, int group, char* gname, size_t len)
+{
+  size_t n = strlen(fname);
+
+  if (n >= 3 && strcmp(fname + n - 3, ".h5") == 0)
+    n -= 3;
+  snprintf(gname, len, "%.*s-grp%d.h5", (int)n, fname, group);
+}
+
+void group_config(const configuration* config, int size, configuration* group)
+{
+  proc_grid grid;
+
+  write_grid(config, &grid);
+  memcpy(group, config, sizeof(configuration));
+  group->rows = grid.my_rows;
+  group->cols = grid.my_cols;
+  group->proc_rows = 1;
+  group->proc_cols = file_group_size(config, size);
+  group->read_proc_rows = group->read_proc_cols = 0;
+  strncpy(group->scaling, "weak", sizeof(group->scaling));
+}
+
+/*
+ *
+ * Create a virtual dataset which maps the block of each rank (across the
+ * leading step and array dimensions) onto the same dataset in its source
+ * file
+ *
+ */
+
+hid_t create_virtual_dataset(const configuration* config, hid_t file,
+                             const char* name, hid_t lcpl, hid_t dapl,
+                             const char* hdf5_filename, int size)
+{
+  hid_t result, fspace, dcpl;
+  hsize_t start[H5S_MAX_RANK], count[H5S_MAX_RANK], dims[H5S_MAX_RANK];
+  proc_grid grid;
+  char sname[PATH_MAX+16];
+  unsigned int i, lead;
+  int r;
+
+  write_grid(config, &grid);
+  assert((fspace = create_fspace(config)) >= 0);
+  assert(H5Sget_simple_extent_dims(fspace, dims, NULL) == (int)config->rank);
+  assert((dcpl = H5Pcreate(H5P_DATASET_CREATE)) >= 0);
+
+  lead = config->rank - 2;
+  for (i = 0; i < lead; ++i)
+    {
+      start[i] = 0;
+      count[i] = dims[i];
+    }
+  count[lead] = (hsize_t)grid.my_rows;
+  count[lead + 1] = (hsize_t)grid.my_cols;
+
+  for (r = 0; r < size; ++r)
+    {
+      start[lead] = (hsize_t)(r / grid.proc_cols)*grid.my_rows;
+      start[lead + 1] = (hsize_t)(r % grid.proc_cols)*grid.my_cols;
+      assert(H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, NULL, count,
+                                 NULL) >= 0);
+      source_file_name(hdf5_filename, r, sname, sizeof(sname));
+      assert(H5Pset_virtual(dcpl, fspace, sname, name, fspace) >= 0);
+    }
+
+  assert(H5Sselect_all(fspace) >= 0);
+  assert((result = H5Dcreate(file, name, H5T_NATIVE_DOUBLE, fspace,
+                             lcpl, dcpl, dapl)) >= 0);
+
+  assert(H5Pclose(dcpl) >= 0);
+  assert(H5Sclose(fspace) >= 0);
+  return result;
+}
+
+/*
+ *
+ * The writer's process grid and the (N-to-M) reader's grid, which splits the
+ * same global array among read-process-rows x read-process-columns ranks
+ *
+ */
+
+void write_grid(const configuration* config, proc_grid* grid)
+{
+  unsigned int strong_scaling_flg;
+
+  strong_scaling_flg = (strncmp(config->scaling, "strong", 16) == 0);
+  grid->proc_rows = config->proc_rows;
+  grid->proc_cols = config->proc_cols;
+  grid->my_rows = strong_scaling_flg ? config->rows/config->proc_rows : config->rows;
+  grid->my_cols = strong_scaling_flg ? config->cols/config->proc_cols : config->cols;
+}
+
+void read_grid(const configuration* config, proc_grid* grid)
+{
+  proc_grid w;
+
+  write_grid(config, &w);
+  if (config->read_proc_rows == 0 || config->read_proc_cols == 0)
+    {
+      *grid = w;
+      return;
+    }
+
+  /* validate() made sure that the blocks tile the array */
+  grid->proc_rows = config->read_proc_rows;
+  grid->proc_cols = config->read_proc_cols;
+  grid->my_rows = w.proc_rows*w.my_rows/grid->proc_rows;
+  grid->my_cols = w.proc_cols*w.my_cols/grid->proc_cols;
+}
+
+/*
+ *
+ * Create an in-file dataspace selection depending on the step and variable:
+ * the part of the array of the rank at (proc_row, proc_col) in grid (the
+ * writer's or the reader's), as given by pattern. A rank outside the grid
+ * (proc_row < 0) selects nothing, but still takes part in collective calls.
  *
  */
 
 int create_selection(const configuration* config,
+                     const proc_grid* grid,
                      hid_t fspace,
                      const int proc_row,
                      const int proc_col,
                      const unsigned int step,
-                     const unsigned int array)
+                     const unsigned int array,
+                     selection_pattern pattern)
 {
   hid_t result = 0;
-  unsigned int strong_scaling_flg, step_first_flg;
-  unsigned long my_rows, my_cols;
-  hsize_t start[H5S_MAX_RANK], count[H5S_MAX_RANK], block[H5S_MAX_RANK];
+  unsigned int step_first_flg;
+  hsize_t start[H5S_MAX_RANK], stride[H5S_MAX_RANK], count[H5S_MAX_RANK];
+  hsize_t block[H5S_MAX_RANK];
+  hsize_t row0, col0, nrows, ncols;
+  unsigned int i, lead;
 
-  strong_scaling_flg = (strncmp(config->scaling, "strong", 16) == 0);
-  my_rows = strong_scaling_flg ? config->rows/config->proc_rows : config->rows;
-  my_cols = strong_scaling_flg ? config->cols/config->proc_cols : config->cols;
+  assert(H5Sselect_none(fspace) >= 0);
+  if (proc_row < 0)
+    return result;
 
   step_first_flg = (strncmp(config->slowest_dimension, "step", 16) == 0);
 
+  /* the leading (step and array) dimensions */
+  lead = config->rank - 2;
   switch (config->rank)
     {
-    case 2:
-      start[0] = (hsize_t)proc_row*my_rows;
-      start[1] = (hsize_t)proc_col*my_cols;
-      count[0] = count[1] = 1;
-      block[0] = (hsize_t)my_rows;
-      block[1] = (hsize_t)my_cols;
-      break;
     case 3:
       start[0] = (hsize_t)
         (step_first_flg ? array : step);
-      start[1] = (hsize_t)proc_row*my_rows;
-      start[2] = (hsize_t)proc_col*my_cols;
-      count[0] = count[1] = count[2] = 1;
-      block[0] = 1;
-      block[1] = (hsize_t)my_rows;
-      block[2] = (hsize_t)my_cols;
       break;
     case 4:
       start[0] = (hsize_t)
         (step_first_flg ? step : array);
       start[1] = (hsize_t)
         (step_first_flg ? array : step);
-      start[2] = (hsize_t)proc_row*my_rows;
-      start[3] = (hsize_t)proc_col*my_cols;
-      count[0] = count[1] = count[2] = count[3] = 1;
-      block[0] = block[1] = 1;
-      block[2] = (hsize_t)my_rows;
-      block[3] = (hsize_t)my_cols;
+      break;
+    default:
+      break;
+    }
+  for (i = 0; i < lead; ++i)
+    stride[i] = count[i] = block[i] = 1;
+
+  /* the rows and columns */
+  row0  = (hsize_t)proc_row*grid->my_rows;
+  col0  = (hsize_t)proc_col*grid->my_cols;
+  nrows = (hsize_t)grid->my_rows;
+  ncols = (hsize_t)grid->my_cols;
+  stride[lead] = stride[lead + 1] = 1;
+  count[lead] = count[lead + 1] = 1;
+
+  switch (pattern)
+    {
+    case SELECT_STRIDED:
+      stride[lead] = stride[lead + 1] = config->read_stride;
+      count[lead]  = (nrows + config->read_stride - 1)/config->read_stride;
+      count[lead + 1] = (ncols + config->read_stride - 1)/config->read_stride;
+      nrows = ncols = 1;
+      break;
+    case SELECT_COLUMN_SLAB:
+      {
+        /* case_possible() made sure that the columns split evenly */
+        hsize_t width = ((hsize_t)grid->proc_cols*grid->my_cols)/
+          (grid->proc_rows*grid->proc_cols);
+        col0  = ((hsize_t)proc_row*grid->proc_cols + proc_col)*width;
+        row0  = 0;
+        nrows = (hsize_t)grid->proc_rows*grid->my_rows;
+        ncols = width;
+      }
       break;
     default:
       break;
     }
 
-  assert(H5Sselect_none(fspace) >= 0);
-  assert(H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, NULL, count, block)
-         >= 0);
+  start[lead] = row0;
+  start[lead + 1] = col0;
+  block[lead] = nrows;
+  block[lead + 1] = ncols;
+
+  assert(H5Sselect_hyperslab(fspace, H5S_SELECT_SET, start, stride, count,
+                             block) >= 0);
   return result;
 }
 
+/*
+ *
+ * The read pattern: the shape of the selections and which arrays are read
+ *
+ */
+
+selection_pattern read_selection(const configuration* config)
+{
+  if (strncmp(config->read_pattern, "strided", 16) == 0)
+    return SELECT_STRIDED;
+  if (strncmp(config->read_pattern, "column-slab", 16) == 0)
+    return SELECT_COLUMN_SLAB;
+  return SELECT_BLOCK;
+}
+
+/* random and time-series read a single array per step */
+
+int reads_array(const configuration* config,
+                const unsigned int step,
+                const unsigned int array)
+{
+  if (strncmp(config->read_pattern, "time-series", 16) == 0)
+    return array == 0;
+
+  if (strncmp(config->read_pattern, "random", 16) == 0)
+    {
+      /* the same on all ranks, so that collective reads still match up */
+      unsigned long long x = 0x9E3779B97F4A7C15ULL*(step + 1);
+      x ^= x >> 31;
+      x *= 0xBF58476D1CE4E5B9ULL;
+      x ^= x >> 29;
+      return array == (unsigned int)(x % config->arrays);
+    }
+
+  return 1;
+}
+
+/* the in-memory selection matching a rank's selection in an array */
+
+void select_memory(const configuration* config,
+                   hid_t mspace,
+                   selection_pattern pattern)
+{
+  hsize_t dims[2], start[2] = { 0, 0 }, stride[2], count[2];
+
+  assert(H5Sget_simple_extent_dims(mspace, dims, NULL) == 2);
+  if (pattern == SELECT_STRIDED)
+    {
+      stride[0] = stride[1] = config->read_stride;
+      count[0] = (dims[0] + config->read_stride - 1)/config->read_stride;
+      count[1] = (dims[1] + config->read_stride - 1)/config->read_stride;
+      assert(H5Sselect_hyperslab(mspace, H5S_SELECT_SET, start, stride, count,
+                                 NULL) >= 0);
+    }
+  else /* a column slab has as many elements as a block */
+    assert(H5Sselect_all(mspace) >= 0);
+}
+
 void init_write_buffer(double wbuf[], const size_t* my_rows, const size_t* my_cols, size_t d[], size_t o[])
 {
   size_t i, j;
@@ -276,3 +723,167 @@ void verify_read_buffer(double* rbuf, const size_t* my_rows, const size_t* my_co
                   (double) (((o[0]*d[1] + o[1])*d[2] + o[2] + i)*d[3] + o[3] + j))
              < 1.e-12);
 }
+
+/*
+ *
+ * A model of the raw data chunk cache of one open dataset
+ *
+ * HDF5 does not expose chunk cache statistics, so we replay the chunk
+ * accesses of this rank against a cache of the configured size: a chunk
+ * hashes into one of nslots slots, evicting a different chunk held in the
+ * same slot, and the least recently used chunks are evicted when nbytes
+ * would be exceeded. Chunks larger than nbytes bypass the cache. The w0
+ * preemption policy is not modeled.
+ *
+ */
+
+void cc_model_init(cc_model* pm, const configuration* config)
+{
+  size_t i;
+
+  memset(pm, 0, sizeof(cc_model));
+
+  pm->chunked = (strncmp(config->layout, "chunked", 16) == 0);
+  if (!pm->chunked)
+    return;
+
+  pm->rank = config->rank;
+  chunk_dims(config, pm->cdims);
+  pm->chunk_bytes = sizeof(double);
+  for (i = 0; i < pm->rank; ++i)
+    pm->chunk_bytes *= (size_t)pm->cdims[i];
+
+  pm->nslots = config->chunk_cache_nslots > 0 ? config->chunk_cache_nslots : 1;
+  pm->nbytes = config->chunk_cache_nbytes;
+
+  assert((pm->slot = (hsize_t*) calloc(pm->nslots, sizeof(hsize_t))) != NULL);
+  assert((pm->prev = (size_t*) malloc(pm->nslots*sizeof(size_t))) != NULL);
+  assert((pm->next = (size_t*) malloc(pm->nslots*sizeof(size_t))) != NULL);
+  cc_model_reset(pm);
+}
+
+void cc_model_free(cc_model* pm)
+{
+  if (pm->chunked)
+    {
+      free(pm->slot);
+      free(pm->prev);
+      free(pm->next);
+    }
+}
+
+/* A dataset was (re-)opened and starts out with an empty cache */
+
+void cc_model_reset(cc_model* pm)
+{
+  if (!pm->chunked)
+    return;
+
+  memset(pm->slot, 0, pm->nslots*sizeof(hsize_t));
+  pm->head = pm->tail = pm->nslots; /* nslots marks the end of the LRU list */
+  pm->used = 0;
+}
+
+static void cc_unlink(cc_model* pm, size_t s)
+{
+  if (pm->prev[s] != pm->nslots)
+    pm->next[pm->prev[s]] = pm->next[s];
+  else
+    pm->head = pm->next[s];
+
+  if (pm->next[s] != pm->nslots)
+    pm->prev[pm->next[s]] = pm->prev[s];
+  else
+    pm->tail = pm->prev[s];
+}
+
+static void cc_push_front(cc_model* pm, size_t s)
+{
+  pm->prev[s] = pm->nslots;
+  pm->next[s] = pm->head;
+  if (pm->head != pm->nslots)
+    pm->prev[pm->head] = s;
+  else
+    pm->tail = s;
+  pm->head = s;
+}
+
+static void cc_evict(cc_model* pm, size_t s)
+{
+  cc_unlink(pm, s);
+  pm->slot[s] = 0;
+  pm->used -= pm->chunk_bytes;
+}
+
+static void cc_touch(cc_model* pm, hsize_t idx)
+{
+  size_t s = (size_t)(idx % pm->nslots);
+
+  if (pm->slot[s] == idx + 1) /* slots store the chunk index + 1 */
+    {
+      ++pm->hits;
+      cc_unlink(pm, s);
+      cc_push_front(pm, s);
+      return;
+    }
+
+  ++pm->misses;
+  if (pm->chunk_bytes > pm->nbytes)
+    return;
+
+  if (pm->slot[s] != 0)
+    cc_evict(pm, s);
+  while (pm->used + pm->chunk_bytes > pm->nbytes)
+    cc_evict(pm, pm->tail);
+
+  pm->slot[s] = idx + 1;
+  cc_push_front(pm, s);
+  pm->used += pm->chunk_bytes;
+}
+
+/* Record the chunks touched by the selection in fspace */
+
+void cc_model_access(cc_model* pm, hid_t fspace)
+{
+  hsize_t dims[H5S_MAX_RANK], start[H5S_MAX_RANK], end[H5S_MAX_RANK];
+  hsize_t first[H5S_MAX_RANK], last[H5S_MAX_RANK], c[H5S_MAX_RANK];
+  hsize_t nchunks[H5S_MAX_RANK], idx;
+  int i;
+  hssize_t npoints;
+
+  assert((npoints = H5Sget_select_npoints(fspace)) >= 0);
+  pm->bytes += (unsigned long long)npoints*sizeof(double);
+
+  if (!pm->chunked || npoints == 0)
+    return;
+
+  assert(H5Sget_simple_extent_dims(fspace, dims, NULL) == (int)pm->rank);
+  assert(H5Sget_select_bounds(fspace, start, end) >= 0);
+
+  for (i = 0; i < (int)pm->rank; ++i)
+    {
+      nchunks[i] = (dims[i] + pm->cdims[i] - 1)/pm->cdims[i];
+      c[i] = first[i] = start[i]/pm->cdims[i];
+      last[i] = end[i]/pm->cdims[i];
+    }
+
+  for (;;)
+    {
+      idx = 0;
+      for (i = 0; i < (int)pm->rank; ++i)
+        idx = idx*nchunks[i] + c[i];
+      cc_touch(pm, idx);
+
+      for (i = (int)pm->rank - 1; i >= 0; --i)
+        {
+          if (c[i] < last[i])
+            {
+              ++c[i];
+              break;
+            }
+          c[i] = first[i];
+        }
+      if (i < 0)
+        break;
+    }
+}
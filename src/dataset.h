@@ -27,8 +27,65 @@ struct time_step {
     hid_t              es_meta_data;
 };
 
+/* A model of one open dataset's raw data chunk cache */
+
+typedef struct
+{
+  unsigned int       chunked;
+  unsigned int       rank;
+  hsize_t            cdims[H5S_MAX_RANK];
+  size_t             chunk_bytes;
+  size_t             nslots;
+  size_t             nbytes;
+  size_t             used;   /* bytes held in the cache */
+  hsize_t*           slot;   /* chunk index + 1 per hash slot, 0=empty */
+  size_t*            prev;   /* LRU list of occupied slots */
+  size_t*            next;
+  size_t             head;
+  size_t             tail;
+  unsigned long long hits;
+  unsigned long long misses;
+  unsigned long long bytes;  /* selected by all accesses */
+} cc_model;
+
+/* The shape of a rank's selection in an array */
+
+typedef enum selection_pattern
+{
+  SELECT_BLOCK,        /* the rank's block of the process grid */
+  SELECT_STRIDED,      /* every read-stride-th row and column of the block */
+  SELECT_COLUMN_SLAB   /* all rows of a 1/size share of the columns */
+} selection_pattern;
+
+/* A process grid and the block of an array per process */
+
+typedef struct
+{
+  unsigned int  proc_rows;
+  unsigned int  proc_cols;
+  unsigned long my_rows;
+  unsigned long my_cols;
+} proc_grid;
+
+extern void write_grid(const configuration* config, proc_grid* grid);
+
+extern void read_grid(const configuration* config, proc_grid* grid);
+
+extern int chunk_shape(const configuration* config,
+                       hsize_t* crows,
+                       hsize_t* ccols);
+
+extern void chunk_dims(const configuration* config, hsize_t cdims[]);
+
+extern int filtered(const configuration* config,
+                    unsigned int coll_mpi_io_flg);
+
 extern hid_t create_dcpl(const configuration* config, unsigned int coll_mpi_io_flg);
 
+extern int compact_fits(const configuration* config);
+
+extern unsigned long long objects_created(const configuration* config);
+
 extern hid_t create_dataset(const configuration* config,
                             hid_t file,
                             const char* name,
@@ -37,12 +94,45 @@ extern hid_t create_dataset(const configuration* config,
                             unsigned int coll_mpi_io_flg,
                             time_step *ts);
 
+extern void source_file_name(const char* fname, int rank, char* sname,
+                             size_t len);
+
+extern unsigned int file_groups(const configuration* config, int size);
+
+extern unsigned int file_group_size(const configuration* config, int size);
+
+extern void group_file_name(const char* fname, int group, char* gname,
+                            size_t len);
+
+extern void group_config(const configuration* config, int size,
+                         configuration* group);
+
+extern hid_t create_virtual_dataset(const configuration* config,
+                                    hid_t file,
+                                    const char* name,
+                                    hid_t lcpl,
+                                    hid_t dapl,
+                                    const char* hdf5_filename,
+                                    int size);
+
 extern int create_selection(const configuration* config,
+                            const proc_grid* grid,
                             hid_t fspace,
                             const int proc_row,
                             const int proc_col,
                             const unsigned int step,
-                            const unsigned int array);
+                            const unsigned int array,
+                            selection_pattern pattern);
+
+extern selection_pattern read_selection(const configuration* config);
+
+extern int reads_array(const configuration* config,
+                       const unsigned int step,
+                       const unsigned int array);
+
+extern void select_memory(const configuration* config,
+                          hid_t mspace,
+                          selection_pattern pattern);
 
 extern void init_write_buffer(double wbuf[],
                               const size_t* my_rows,
@@ -56,6 +146,14 @@ extern void verify_read_buffer(double* rbuf,
                                size_t d[],
                                size_t o[]);
 
+extern void cc_model_init(cc_model* pm, const configuration* config);
+
+extern void cc_model_free(cc_model* pm);
+
+extern void cc_model_reset(cc_model* pm);
+
+extern void cc_model_access(cc_model* pm, hid_t fspace);
+
 extern void async_sleep(hid_t file_id, 
                         hid_t fapl, 
                         duration sleep_time);
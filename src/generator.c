@@ -0,0 +1,193 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#include "generator.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* splitmix64, a counter-based generator, so that the fill can be parallel */
+
+static uint64_t mix64(uint64_t x)
+{
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27))*0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+/*
+ *
+ * Without a generator, compressed datasets get the smooth field and the
+ * others a constant
+ *
+ */
+
+const char* generator_name(const configuration* config)
+{
+  if (config->data_generator[0] != '\0')
+    return config->data_generator;
+  return (strcmp(config->filter, "none") != 0) ? "smooth" : "constant";
+}
+
+int generator_check(const configuration* config)
+{
+  const char* name = generator_name(config);
+
+  if (strcmp(name, "constant") == 0 || strcmp(name, "smooth") == 0 ||
+      strcmp(name, "random") == 0)
+    return 0;
+  if (strcmp(name, "noisy") == 0)
+    return (config->data_entropy_bits <= 52) ? 0 : -1;
+  if (strcmp(name, "file") == 0)
+    return (config->data_file[0] != '\0' &&
+            config->data_dataset[0] != '\0') ? 0 : -1;
+  return -1;
+}
+
+/*
+ *
+ * Fill a rank's block. The field is defined on the global array, so that the
+ * data doesn't repeat from rank to rank.
+ *
+ */
+
+static void fill_field(const configuration* config,
+                       const proc_grid* grid,
+                       int proc_row,
+                       int proc_col,
+                       unsigned int noise_bits,
+                       double* wbuf)
+{
+  long i;
+  double grows = (double)(grid->proc_rows*grid->my_rows);
+  double gcols = (double)(grid->proc_cols*grid->my_cols);
+  uint64_t mask = (noise_bits > 0) ? (~0ULL >> (64 - noise_bits)) : 0;
+
+#pragma omp parallel for
+  for (i = 0; i < (long)grid->my_rows; ++i)
+    {
+      size_t j;
+      uint64_t grow = (uint64_t)proc_row*grid->my_rows + (uint64_t)i;
+      double x = (double)grow/(grows > 1.0 ? grows - 1.0 : 1.0) - 0.5;
+
+      for (j = 0; j < grid->my_cols; ++j)
+        {
+          uint64_t gcol = (uint64_t)proc_col*grid->my_cols + j;
+          double y = (double)gcol/(gcols > 1.0 ? gcols - 1.0 : 1.0) - 0.5;
+          double v = x*x + y*y;
+
+          if (mask != 0)
+            { /* randomize the low mantissa bits */
+              uint64_t u;
+              memcpy(&u, &v, sizeof(u));
+              u ^= mix64(config->data_seed ^ (grow*(uint64_t)gcols + gcol)) & mask;
+              memcpy(&v, &u, sizeof(v));
+            }
+          wbuf[i*grid->my_cols + j] = v;
+        }
+    }
+}
+
+static void fill_random(const configuration* config,
+                        const proc_grid* grid,
+                        int proc_row,
+                        int proc_col,
+                        double* wbuf)
+{
+  long i;
+  uint64_t gcols = (uint64_t)grid->proc_cols*grid->my_cols;
+
+#pragma omp parallel for
+  for (i = 0; i < (long)grid->my_rows; ++i)
+    {
+      size_t j;
+      uint64_t grow = (uint64_t)proc_row*grid->my_rows + (uint64_t)i;
+
+      for (j = 0; j < grid->my_cols; ++j)
+        {
+          uint64_t gcol = (uint64_t)proc_col*grid->my_cols + j;
+          /* 53 random bits in [0, 1) */
+          wbuf[i*grid->my_cols + j] = (double)
+            (mix64(config->data_seed ^ (grow*gcols + gcol)) >> 11)*0x1.0p-53;
+        }
+    }
+}
+
+/* Read the whole dataset and tile the block with it, starting at an offset
+   that depends on the rank's position */
+
+static void fill_from_file(const configuration* config,
+                           const proc_grid* grid,
+                           int proc_row,
+                           int proc_col,
+                           double* wbuf)
+{
+  hid_t file, dset, fspace;
+  hssize_t npoints;
+  double* src;
+  size_t n = grid->my_rows*grid->my_cols, k, off;
+
+  assert((file = H5Fopen(config->data_file, H5F_ACC_RDONLY, H5P_DEFAULT)) >= 0);
+  assert((dset = H5Dopen(file, config->data_dataset, H5P_DEFAULT)) >= 0);
+  assert((fspace = H5Dget_space(dset)) >= 0);
+  assert((npoints = H5Sget_simple_extent_npoints(fspace)) > 0);
+  assert((src = (double*) malloc((size_t)npoints*sizeof(double))) != NULL);
+  assert(H5Dread(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, src)
+         >= 0);
+  assert(H5Sclose(fspace) >= 0);
+  assert(H5Dclose(dset) >= 0);
+  assert(H5Fclose(file) >= 0);
+
+  off = (((size_t)proc_row*grid->proc_cols + (size_t)proc_col)*n) %
+    (size_t)npoints;
+  for (k = 0; k < n; ++k)
+    wbuf[k] = src[(off + k) % (size_t)npoints];
+
+  free(src);
+}
+
+void fill_write_buffers(const configuration* config,
+                        const proc_grid* grid,
+                        int proc_row,
+                        int proc_col,
+                        unsigned int nbuf,
+                        double* wbufs)
+{
+  const char* name = generator_name(config);
+  size_t n = grid->my_rows*grid->my_cols;
+  unsigned int b;
+
+  if (strcmp(name, "smooth") == 0)
+    fill_field(config, grid, proc_row, proc_col, 0, wbufs);
+  else if (strcmp(name, "noisy") == 0)
+    fill_field(config, grid, proc_row, proc_col, config->data_entropy_bits,
+               wbufs);
+  else if (strcmp(name, "random") == 0)
+    fill_random(config, grid, proc_row, proc_col, wbufs);
+  else if (strcmp(name, "file") == 0)
+    fill_from_file(config, grid, proc_row, proc_col, wbufs);
+  else
+    {
+      long i;
+#pragma omp parallel for
+      for (i = 0; i < (long)n; ++i)
+        wbufs[i] = (double) (proc_row + proc_col);
+    }
+
+  /* the rotating async write buffers hold the same data */
+  for (b = 1; b < nbuf; ++b)
+    memcpy(wbufs + b*n, wbufs, n*sizeof(double));
+}
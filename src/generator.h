@@ -0,0 +1,39 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "configuration.h"
+#include "dataset.h"
+
+/*
+ * Synthetic data for the write buffers. The compressibility of the data
+ * decides what compression (and deduplication) achieves, so the generators
+ * range from a constant, via a smooth field and a smooth field with a
+ * tunable number of random mantissa bits, to uniform random values. The data
+ * can also be taken from an existing HDF5 dataset.
+ */
+
+extern int generator_check(const configuration* config);
+
+extern const char* generator_name(const configuration* config);
+
+extern void fill_write_buffers(const configuration* config,
+                               const proc_grid* grid,
+                               int proc_row,
+                               int proc_col,
+                               unsigned int nbuf,
+                               double* wbufs);
+
+#endif
@@ -11,6 +11,10 @@
 
 */
 
+#include "cases.h"
+#include "dataset.h"
+#include "generator.h"
+#include "pipeline.h"
 #include "read_test.h"
 #include "utils.h"
 #include "write_test.h"
@@ -24,40 +28,43 @@
 #include <stdlib.h>
 #include <string.h>
 
-#define  TEST_FOR(INI, CHK, CNT) for ((INI); (CHK); (CNT)) {
-#define  END_TEST }
-
 #define CONFIG_FILE "hdf5_iotest.ini"
 
 int main(int argc, char* argv[])
 {
   const char* ini = (argc > 1) ? argv[1] : CONFIG_FILE;
 
-  configuration config;
+  configuration config, group, *pcase;
   unsigned int strong_scaling_flg, coll_mpi_io_flg;
 
-  int size, rank, my_proc_row, my_proc_col;
+  int size, rank;
   unsigned long my_rows, my_cols;
+  proc_grid wgrid;
+  MPI_Comm comm;
+  MPI_Info info;
+  unsigned int ngroups;
+  int crank, csize, case_row, case_col, case_read_row, case_read_col;
+  proc_grid case_rgrid;
+  double* wdata;
+  unsigned int nbuf;
 
-  unsigned int irank, islow, ifill, ilay, ialig, imblk, ifmt, imod;
-  unsigned int ckpt_flg;
-  restart_t ckpt;
-
-  char* slow_dim[2]      = { "step", "array" };
-  char* fill[2]          = { "true", "false" };
-  char* layout[2]        = { "contiguous", "chunked" };
-  hsize_t align_incr[2]  = { 1, 1 };
-  hsize_t align_thold[2] = { 0, 0 };
-  hsize_t mblk_size[2]   = { 2048, 0 };
-  char* fmt_low[2]       = { "earliest", "latest" };
-  char* mpi_mod[2]       = { "independent", "collective" };
+  case_iter it;
+  unsigned int ncases, ncombinations, nskip = 0;
 
-  hid_t fcpl, fapl, dapl, dxpl, lcpl, fapl_cpy, fapl_split;
+  hid_t fcpl, fapl, dapl, dxpl, lcpl, fapl_cpy, fapl_split, fapl_rank;
+  unsigned int virtual_flg;
 
   double wall_time, create_time, write_phase, write_time, read_phase, read_time;
-  timings ts;
+  timings ts, rep_ts;
+  rep_stats rs;
+  double* samples;
+  rank_timing *rank_ts, *rank_sum;
+  unsigned int irep, nrep;
+  int done;
+  latency* lat;
+  io_stats stats;
+  unsigned long long filter_ns;
   int icase = 0;
-  int nmod = 0;
 
   int         mpi_thread_lvl_provided = -1;
   MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &mpi_thread_lvl_provided);
@@ -73,7 +80,9 @@ int main(int argc, char* argv[])
   if (rank == 0) /* rank 0 reads and checks the config. file */
     {
       uuid_t uuid;
+      hid_t tmp;
       /* sensible defaults */
+      memset(&config, 0, sizeof(configuration));
       config.rank = 4;
       config.hdf5_file[0] = '\0';
       config.csv_file[0] = '\0';
@@ -81,15 +90,54 @@ int main(int argc, char* argv[])
       config.split = 0;
       config.delay.time_num = 0;
       config.async = 0;
+      config.async_buffers = 1;
+      config.read_stride = 2;
+      config.repetitions = 1;
+      config.warmup = 0;
+      config.ci_target = 0.0;
+      strcpy(config.tune, "none");
+      config.tune_budget = 0;
+      config.multi_dataset = 0;
+      config.subfiling = 0;
+      config.subfiling_stripe_size = 0;  /* the library defaults */
+      config.subfiling_ioc_per_node = 0;
+      strncpy(config.chunk_shape, "block", sizeof(config.chunk_shape));
+      config.alignment_increment = 1;
+      config.alignment_threshold = 0;
+      config.meta_block_size = 2048;
+      config.fspace_page_size = 0;
+      config.page_buffer_size = 0;
+      strcpy(config.mdc_config, "default");
+      config.evict_on_close = 0;
+      config.mdc_image = 0;
+      config.attributes = 0;
+      config.attribute_size = 8;
+      config.attr_max_compact = 8;  /* the library defaults */
+      config.attr_min_dense = 6;
+      config.track_times = 1;
+      config.no_attrs_hint = 0;
+      config.file_groups = 1;
+      strcpy(config.mpi_hints, "none");
+      /* the library's default raw data chunk cache */
+      assert((tmp = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
+      assert(H5Pget_cache(tmp, NULL, &config.chunk_cache_nslots,
+                          &config.chunk_cache_nbytes,
+                          &config.chunk_cache_w0) >= 0);
+      assert(H5Pclose(tmp) >= 0);
       config.one_case = 0;
       config.HDF5perCase = 0;
       config.compress_type[0] = '\0';
+      strcpy(config.filter, "none");
+      config.plugin_path[0] = '\0';
+      strcpy(config.chunk_write, "library");
+      config.threads_per_rank = 1;
 
       if (ini_parse(ini, handler, &config) < 0)
         {
           printf("Can't load '%s'\n", ini);
           return 1;
         }
+      cases_init(&config);
       if (config.csv_file[0] == '\0')
         {
           uuid_generate_time_safe(uuid);
@@ -107,33 +155,27 @@ int main(int argc, char* argv[])
   /* broadcast the input parameters */
   MPI_Bcast(&config, sizeof(configuration), MPI_BYTE, 0, MPI_COMM_WORLD);
 
+  /* where to look for filter plugins (in addition to HDF5_PLUGIN_PATH) */
+  if (config.plugin_path[0] != '\0')
+    pipeline_plugin_path(config.plugin_path);
+
   validate(&config, size);
+  assert(cases_check(&config, size) == 0);
 
+  ncases = case_count(&config, size, &ncombinations);
   if (rank == 0)
-    print_initial_config(ini, &config);
+    {
+      print_initial_config(ini, &config);
+      printf("Cases: %u (of %u combinations)\n", ncases, ncombinations);
+    }
 
-  ckpt_flg = 0;
   if (config.restart == 1) {
     if (rank == 0) /* rank 0 reads the last successful configuration */
-      {
-        restart(&ckpt, 
-                config.csv_file,
-                slow_dim,
-                fill,
-                layout,
-                fmt_low,
-                mpi_mod,
-                mblk_size,
-                align_incr);
-      }
+      nskip = restart(config.csv_file);
     /* broadcast the restart parameters */
-    MPI_Bcast(&ckpt, sizeof(ckpt), MPI_BYTE, 0, MPI_COMM_WORLD);
-    ckpt_flg = 1;
+    MPI_Bcast(&nskip, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
   }
 
-  my_proc_row = rank / config.proc_cols;
-  my_proc_col = rank % config.proc_cols;
-
   /* create the output CSV file */
   if (rank == 0 && config.restart == 0)
     create_output_file(config.csv_file);
@@ -143,6 +185,11 @@ int main(int argc, char* argv[])
   my_rows = strong_scaling_flg ? config.rows/config.proc_rows : config.rows;
   my_cols = strong_scaling_flg ? config.cols/config.proc_cols : config.cols;
 
+  /* the write buffers (one per async buffer in flight) */
+  nbuf = (config.async == 1) ? config.async_buffers : 1;
+  assert((wdata = (double*) malloc(nbuf*my_rows*my_cols*sizeof(double)))
+         != NULL);
+
   assert((fcpl = H5Pcreate(H5P_FILE_CREATE)) >= 0);
   assert((fapl = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
   assert((dapl = H5Pcreate(H5P_DATASET_ACCESS)) >= 0);
@@ -152,7 +199,6 @@ int main(int argc, char* argv[])
 
   if (size > 1 || (strncmp(config.single_process, "mpi-io-uni", 16) == 0))
     {
-      assert(H5Pset_fapl_mpio(fapl, MPI_COMM_WORLD, MPI_INFO_NULL) >= 0);
       assert(H5Pset_all_coll_metadata_ops(fapl, 1) >= 0);
       assert(H5Pset_coll_metadata_write(fapl, 1) >= 0);
     }
@@ -162,231 +208,327 @@ int main(int argc, char* argv[])
     else
       assert(H5Pset_fapl_sec2(fapl) >= 0);
 
-  /* test collective and independent modes when parallel, and greater than 0 ranks */
-  if (size > 1) nmod = 1;
+  assert((lat = (latency*) malloc(sizeof(latency))) != NULL);
+  assert((samples = (double*) malloc(config.repetitions*NTIMINGS*
+                                     sizeof(double))) != NULL);
+  assert((rank_ts = (rank_timing*) malloc(size*sizeof(rank_timing))) != NULL);
+  assert((rank_sum = (rank_timing*) malloc(size*sizeof(rank_timing))) != NULL);
 
   char hdf5_filename[strlen(config.hdf5_file)+1];
+  char case_filename[strlen(config.hdf5_file)+32];
 
-  /* use a macro to stop the indentation madness */
-
-  /* ======================================================================== */
-  /* dataset rank */
-  TEST_FOR (irank = 2, irank <= 4, ++irank);
-  if(config.restart == 1 && ckpt_flg == 1) irank = ckpt.irank;
-  config.rank = irank;
-
-  /* ======================================================================== */
-  /* slowest changing dimension */
-  TEST_FOR (islow = 0, islow <= 1, ++islow);
-  if(config.restart == 1 && ckpt_flg == 1) islow= ckpt.islow;
-  strncpy(config.slowest_dimension, slow_dim[islow],
-          sizeof(config.slowest_dimension));
-
-  /* ======================================================================== */
-  /* dataset layout */
-  TEST_FOR (ilay = 0, ilay <= 1, ++ilay);
-  if(config.restart == 1 && ckpt_flg == 1) ilay = ckpt.ilay;
-  strncpy(config.layout, layout[ilay], sizeof(config.layout));
-
-  /* ======================================================================== */
-  /* write fill values */
-  TEST_FOR (ifill = 0, ifill <= 1, ++ifill);
-  if(config.restart == 1 && ckpt_flg == 1) ifill = ckpt.ifill;
-  strncpy(config.fill_values, fill[ifill], sizeof(config.fill_values));
-
-  /* ======================================================================== */
-  /* alignment */
-  TEST_FOR (ialig = 0, ialig <= 1, ++ialig);
-  if(config.restart == 1 && ckpt_flg == 1) {
-    ialig = ckpt.ialig;
-    if (ialig == 1) {
-      align_incr[1]  = config.alignment_increment;
-      align_thold[1] = config.alignment_threshold;
-    }
-  }
-  if (ialig == 0) /* run the baseline first */
+  case_begin(&config, &it);
+  while (case_next(&config, size, &it))
     {
-      align_incr[1]  = config.alignment_increment;
-      align_thold[1] = config.alignment_threshold;
-      config.alignment_increment = align_incr[0];
-      config.alignment_threshold = align_thold[0];
-    }
-  else
-    { /* check if we need to run anything beyond the baseline */
-      if (align_incr[1] == 1 && align_thold[1] == 0)
-        continue;
+      ++icase;
+
+      if (icase <= (int)nskip) continue; /* completed before the restart */
+      if (config.one_case > 0 && config.one_case != icase) continue;
+
+      /* with a file per group of ranks, each group runs the case on a
+         communicator and file of its own (see group_config) */
+      ngroups = file_groups(&config, size);
+      pcase = &config;
+      comm = MPI_COMM_WORLD;
+      crank = rank;
+      csize = size;
+      if (ngroups > 1)
+        {
+          MPI_Comm_split(MPI_COMM_WORLD, rank/(size/ngroups), rank, &comm);
+          MPI_Comm_rank(comm, &crank);
+          MPI_Comm_size(comm, &csize);
+          group_config(&config, size, &group);
+          pcase = &group;
+        }
+      case_row = crank / pcase->proc_cols;
+      case_col = crank % pcase->proc_cols;
+      /* the read phase may split the array among fewer or differently
+         arranged ranks; the others take part in collective calls with empty
+         selections */
+      read_grid(pcase, &case_rgrid);
+      case_read_row = case_read_col = -1;
+      if ((unsigned int)crank < case_rgrid.proc_rows*case_rgrid.proc_cols)
+        {
+          case_read_row = crank / case_rgrid.proc_cols;
+          case_read_col = crank % case_rgrid.proc_cols;
+        }
+
+      assert(H5Pset_alignment(fapl, config.alignment_threshold,
+                              config.alignment_increment) >= 0);
+      assert(H5Pset_meta_block_size(fapl, config.meta_block_size) >= 0);
+      /* paged aggregation (file creation) and the page buffer (access) */
+      if (config.fspace_page_size > 0)
+        {
+          assert(H5Pset_file_space_strategy(fcpl, H5F_FSPACE_STRATEGY_PAGE,
+                                            0, (hsize_t)1) >= 0);
+          assert(H5Pset_file_space_page_size(fcpl,
+                                             config.fspace_page_size) >= 0);
+        }
       else
+        assert(H5Pset_file_space_strategy(fcpl, H5F_FSPACE_STRATEGY_FSM_AGGR,
+                                          0, (hsize_t)1) >= 0);
+      assert(H5Pset_page_buffer_size(fapl, config.page_buffer_size, 0, 0)
+             >= 0);
+      assert(set_mdc_config(&config, fapl) >= 0);
+      assert(H5Pset_chunk_cache(dapl, config.chunk_cache_nslots,
+                                config.chunk_cache_nbytes,
+                                config.chunk_cache_w0) >= 0);
+      assert(set_libver_bounds(&config, rank, fapl) >= 0);
+
+      info = MPI_INFO_NULL;
+      if (size > 1 || (strncmp(config.single_process, "mpi-io-uni", 16) == 0))
         {
-          config.alignment_increment = align_incr[1];
-          config.alignment_threshold = align_thold[1];
+          if (config.subfiling)
+            assert(set_fapl_subfiling(&config, fapl) >= 0);
+          else
+            {
+              create_mpi_info(&config, &info);
+              assert(H5Pset_fapl_mpio(fapl, comm, info) >= 0);
+            }
         }
-    }
 
-  assert(H5Pset_alignment(fapl, config.alignment_threshold,
-                          config.alignment_increment) >= 0);
+      coll_mpi_io_flg = 0;
+      if (size > 1)
+        {
+          coll_mpi_io_flg = (strncmp(config.mpi_io, "collective", 15) == 0);
 
-  /* ======================================================================== */
-  /* meta block size */
-  TEST_FOR (imblk = 0, imblk <= 1, ++imblk);
-  if(config.restart == 1 && ckpt_flg == 1) {
-    imblk = ckpt.imblk;
-    if (imblk == 1) {
-      mblk_size[1]  = config.meta_block_size;
-    }
-  }
-  if (imblk == 0) /* run the baseline first */
-    {
-      mblk_size[1]  = config.meta_block_size;
-      config.meta_block_size = mblk_size[0];
-    }
-  else
-    { /* check if we need to run anything beyond the baseline */
-      if (mblk_size[1] == 2048)
-        continue;
+          if (coll_mpi_io_flg)
+            assert(H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE) >= 0);
+          else
+            assert(H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_INDEPENDENT) >= 0);
+        }
       else
-          config.meta_block_size = mblk_size[1];
-    }
-  assert(H5Pset_meta_block_size(fapl, config.meta_block_size) >= 0);
-
-  /* ======================================================================== */
-  /* lower libver bound */
-  TEST_FOR (ifmt = 0, ifmt <= 1, ++ifmt);
-  if(config.restart == 1 && ckpt_flg == 1)  ifmt = ckpt.ifmt;
-  strncpy(config.libver_bound_low, fmt_low[ifmt],
-          sizeof(config.libver_bound_low));
-  assert(set_libver_bounds(&config, rank, fapl) >= 0);
-
-  /* ======================================================================== */
-  /* MPI-IO mode */
-  TEST_FOR (imod = 0, imod <= nmod, ++imod);
-  ++icase;
-  
-  if(config.one_case > 0 && config.one_case != icase) goto skip;
-  if(config.restart == 1 && ckpt_flg == 1) {
-    imod = ckpt.imod;
-    ckpt_flg = 0;
-  }
+        {
+          if( strncmp(config.single_process, "mpi-io-uni", 16) == 0 &&
+              strcmp(config.filter, "none") != 0 ) {
+            assert(H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE) >= 0);
+            coll_mpi_io_flg = 1;
+          }
+          strncpy(config.mpi_io, config.single_process, sizeof(config.mpi_io));
+        }
 
-  if (size > 1)
-    {
-      if(config.split == 0 )
-        strncpy(config.mpi_io, mpi_mod[imod], sizeof(config.mpi_io)-1);
-      else /* split driver can't do collective I/O */
-        strncpy(config.mpi_io, mpi_mod[0], sizeof(config.mpi_io)-1);
+      /* Set the split file driver if requested.
+       * This needs to be done here so that the metadata and raw data fapl's
+       * parameters are completely set because some fapl APIs, like alignment,
+       * can't be applied to the split driver's fapl */
+      if(config.split == 1 )
+        {
+          assert((fapl_split = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
+          assert(H5Pset_fapl_split(fapl_split, "-m.h5", fapl, "-r.h5", fapl) >= 0);
+          fapl_cpy = fapl;
+          fapl = fapl_split;
+        }
 
-      coll_mpi_io_flg = (strncmp(config.mpi_io, "collective", 15) == 0);
+      validate(&config, size);
 
-      if (coll_mpi_io_flg)
-        assert(H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE) >= 0);
-      else
-        assert(H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_INDEPENDENT) >= 0);
-    }
-  else
-    {
-      if( strncmp(config.single_process, "mpi-io-uni", 16) == 0 &&
-          strcmp(config.compress_type, "") != 0 ) {
-        assert(H5Pset_dxpl_mpio(dxpl, H5FD_MPIO_COLLECTIVE) >= 0);
-        coll_mpi_io_flg = 1;
-      }
-      strncpy(config.mpi_io, config.single_process, sizeof(config.mpi_io));
-      if (imod == 1 && config.restart == 1 )
-        continue;
-    }
-
-  /* Set the split file driver if requested.
-   * This needs to be done here so that the metadata and raw data fapl's
-   * parameters are completely set because some fapl APIs, like alignment,
-   * can't be applied to the split driver's fapl */
-  if(config.split == 1 ) 
-    {
-      assert((fapl_split = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
-      assert(H5Pset_fapl_split(fapl_split, "-m.h5", fapl, "-r.h5", fapl) >= 0);
-      fapl_cpy = fapl;
-      fapl = fapl_split;
-    }
+      if (rank == 0)
+        {
+          print_current_config(&config);
+          printf("Case %d of %u\n", icase, ncases);
+        }
 
-  /* ######################################################################## */
+      strncpy( hdf5_filename, config.hdf5_file, strlen(config.hdf5_file) + 1);
 
-  validate(&config, size);
+      if(config.HDF5perCase != 0)
+        {
+          char buf[5];
+          sprintf(buf, "%04d", icase);
 
-  if (rank == 0)
-    print_current_config(&config);
+          char * num;
+          num = strstr (hdf5_filename,"#");
+          strcpy (num+4, num+1);
+          strncpy (num,buf,4);
+        }
 
-  strncpy( hdf5_filename, config.hdf5_file, strlen(config.hdf5_file) + 1);
+      /* with the virtual layout, each rank writes a source file of its own,
+         and the ranks access all files with the POSIX VFD */
+      virtual_flg = (strncmp(config.layout, "virtual", 16) == 0);
+      fapl_rank = fapl;
+      strcpy(case_filename, hdf5_filename);
+      if (ngroups > 1)
+        group_file_name(hdf5_filename, rank/csize, case_filename,
+                        sizeof(case_filename));
+      if (virtual_flg)
+        {
+          source_file_name(hdf5_filename, rank, case_filename,
+                           sizeof(case_filename));
+          if (size > 1 ||
+              strncmp(config.single_process, "mpi-io-uni", 16) == 0)
+            {
+              assert((fapl_rank = H5Pcopy(fapl)) >= 0);
+              assert(H5Pset_fapl_sec2(fapl_rank) >= 0);
+            }
+        }
 
-  if(config.HDF5perCase != 0)
-    {
-      char buf[5];
-      sprintf(buf, "%04d", icase);
+      /* generate the data outside of the timed region (the write threads
+         have a buffer each), for the rank's block in the case's file */
+      assert((wdata = (double*) realloc(wdata, nbuf*config.threads_per_rank*
+                                        my_rows*my_cols*sizeof(double)))
+             != NULL);
+      write_grid(pcase, &wgrid);
+      fill_write_buffers(pcase, &wgrid, case_row, case_col,
+                         nbuf*config.threads_per_rank, wdata);
+
+      /* estimate the filter pipeline's share of the writes from the cost of
+         encoding one block (all blocks of a rank carry the same data); with
+         direct chunk writes, write_test measures it */
+      filter_ns = 0;
+      if (filtered(&config, coll_mpi_io_flg) &&
+          strncmp(config.chunk_write, "direct", 16) != 0)
+        {
+          hsize_t crows, ccols;
 
-      char * num;
-      num = strstr (hdf5_filename,"#");
-      strcpy (num+4, num+1);
-      strncpy (num,buf,4);
-    }
+          assert(chunk_shape(&config, &crows, &ccols) == 0);
+          filter_ns = (unsigned long long)
+            (1.0e9*config.steps*config.arrays*
+             pipeline_cost(config.filter, wdata, my_rows, my_cols,
+                           crows, ccols));
+        }
 
-  MPI_Barrier(MPI_COMM_WORLD);
+      /* Run the warmup repetitions (discarded) and then up to
+         config.repetitions measured ones. With a CI target, stop as soon as
+         the 95% confidence interval of the wall clock time is tight enough. */
+      memset(&ts, 0, sizeof(timings));
+      memset(rank_sum, 0, size*sizeof(rank_timing));
+      nrep = done = 0;
+      for (irep = 0; irep < config.warmup + config.repetitions && !done; ++irep)
+        {
+          MPI_Barrier(MPI_COMM_WORLD);
+
+          wall_time = -MPI_Wtime();
+          read_time = write_time = create_time = 0.0;
+          latency_reset(lat);
+          memset(&stats, 0, sizeof(io_stats));
+          stats.filter_ns = filter_ns;
+          stats.objects = (crank == 0) ? objects_created(pcase) : 0;
+
+          write_phase = -MPI_Wtime();
+          write_test(pcase, case_filename,
+                     csize, crank, case_row, case_col, my_rows, my_cols,
+                     wdata,
+                     fcpl, fapl_rank, lcpl, dapl, dxpl, coll_mpi_io_flg,
+                     &create_time, &write_time, lat, &stats);
+          if (virtual_flg && rank == 0)
+            write_vds(&config, hdf5_filename, size, fcpl, fapl_rank, lcpl,
+                      dapl, &create_time);
+          write_phase += MPI_Wtime();
+
+          MPI_Barrier(MPI_COMM_WORLD);
+
+          read_phase = -MPI_Wtime();
+          read_test(pcase, virtual_flg ? hdf5_filename : case_filename,
+                    csize, crank, case_read_row, case_read_col,
+                    case_rgrid.my_rows, case_rgrid.my_cols,
+                    fapl_rank, dapl, dxpl,
+                    &create_time, &read_time, lat, &stats);
+
+          read_phase += MPI_Wtime();
+
+          MPI_Barrier(MPI_COMM_WORLD);
+
+          wall_time += MPI_Wtime();
+
+          /* the storage size, outside the timings */
+          write_storage(pcase, case_filename, crank, fapl_rank, dapl, &stats);
+
+          get_timings(write_phase, create_time, write_time, read_phase, read_time,
+                      lat, &stats, rank_ts, &rep_ts);
+
+          if (irep < config.warmup) continue;
+
+          if (rank == 0)
+            {
+              timing_values(wall_time, &rep_ts, samples + nrep*NTIMINGS);
+              timings_add(&ts, &rep_ts, 1.0);
+              rank_timings_add(rank_sum, rank_ts, size, 1.0);
+            }
+          ++nrep;
+
+          if (config.ci_target > 0.0 && nrep >= MIN_CI_REPS)
+            {
+              if (rank == 0)
+                {
+                  get_rep_stats(samples, nrep, &rs);
+                  done = (rs.ci95[0] <= 0.01*config.ci_target*rs.mean[0]);
+                }
+              MPI_Bcast(&done, 1, MPI_INT, 0, MPI_COMM_WORLD);
+            }
+        }
 
-  wall_time = -MPI_Wtime();
-  read_time = write_time = create_time = 0.0;
+      /* the hints that MPI-IO applied (to the first group's file) */
+      if ((size > 1 || strncmp(config.single_process, "mpi-io-uni", 16) == 0)
+          && !config.subfiling && !config.split && !virtual_flg &&
+          rank < csize)
+        log_mpi_hints(config.csv_file, icase, comm, case_filename, info);
+      if (info != MPI_INFO_NULL)
+        MPI_Info_free(&info);
 
-  write_phase = -MPI_Wtime();
-  write_test(&config, hdf5_filename, size, rank, my_proc_row, my_proc_col, my_rows, my_cols,
-             fcpl, fapl, lcpl, dapl, dxpl, coll_mpi_io_flg,
-             &create_time, &write_time);
-  write_phase += MPI_Wtime();
+      if (rank == 0)
+        {
+          timings_add(&ts, &ts, 1.0/nrep - 1.0); /* the means */
+          rank_timings_add(rank_sum, rank_sum, size, 1.0/nrep - 1.0);
+          get_rep_stats(samples, nrep, &rs);
+          print_results(&config, hdf5_filename, &rs, &ts, rank_sum, size,
+                        icase);
+        }
 
-  MPI_Barrier(MPI_COMM_WORLD);
+      /* the tuner goes by the slowest rank's write or read phase */
+      if (strncmp(config.tune, "none", 16) != 0)
+        {
+          double tune_time = 0.0;
+          if (rank == 0)
+            tune_time = (strncmp(config.tune, "write", 16) == 0) ?
+              ts.max_write_phase : ts.max_read_phase;
+          MPI_Bcast(&tune_time, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+          case_report(&it, tune_time);
+        }
 
-  read_phase = -MPI_Wtime();
-  read_test(&config, hdf5_filename, size, rank, my_proc_row, my_proc_col, my_rows, my_cols,
-            fapl, dapl, dxpl,
-            &create_time, &read_time);
+      if (fapl_rank != fapl)
+        assert(H5Pclose(fapl_rank) >= 0);
 
-  read_phase += MPI_Wtime();
+      if (config.split == 1)
+        {
+          assert(H5Pclose(fapl) >= 0); /* close the split driver fapl */
+          fapl = fapl_cpy;
+        }
 
-  MPI_Barrier(MPI_COMM_WORLD);
+      /* clean up the hdf5 files for the case of an HDF5 file per case */
+      if(config.HDF5perCase != 0 && rank == 0) {
+        int len = strlen(hdf5_filename) + 8;
+        char* command = malloc( len );
+        strcpy( command, "rm -f " );
+        strcat( command,  hdf5_filename);
+        system(command);
+        free(command);
+      }
+      if (config.HDF5perCase != 0 &&
+          (virtual_flg || (ngroups > 1 && crank == 0)))
+        remove(case_filename);
 
-  wall_time += MPI_Wtime();
+      if (comm != MPI_COMM_WORLD)
+        MPI_Comm_free(&comm);
 
-  get_timings(write_phase, create_time, write_time, read_phase, read_time, &ts);
+      if(config.one_case > 0) break;
+    }
 
-  if (rank == 0)
-    print_results(&config, hdf5_filename, wall_time, &ts);
-  
-  if (config.split == 1) 
+  /* write the best case as an ini file */
+  if (strncmp(config.tune, "none", 16) != 0 && rank == 0 && it.runs > 0)
     {
-      assert(H5Pclose(fapl) >= 0); /* close the split driver fapl */
-      fapl = fapl_cpy;
+      char tname[PATH_MAX+16];
+
+      tuned_file_name(config.csv_file, tname, sizeof(tname));
+      case_write_ini(&config, size, &it, ini, tname);
+      case_best(&config, size, &it);
+      printf("Best of %u cases (%s phase %.4f s), saved to '%s':\n", it.runs,
+             config.tune, it.best_time, tname);
+      print_current_config(&config);
     }
 
-  /* clean up the hdf5 files for the case of an HDF5 file per case */
-  if(config.HDF5perCase != 0 && rank == 0) {
-    int len = strlen(hdf5_filename) + 8;
-    char* command = malloc( len );
-    strcpy( command, "rm -f " );
-    strcat( command,  hdf5_filename);
-    system(command);
-    free(command);
-  }
-  
-  if(config.one_case > 0) goto exitloop;
- skip:
-  continue;
-
-  /* ######################################################################## */
-
-  END_TEST /* MPI-IO mode */
-  END_TEST /* libver bound */
-  END_TEST /* meta block size */
-  END_TEST /* alignment */
-  END_TEST /* fill */
-  END_TEST /* layout */
-  END_TEST /* slow dim. */
-  END_TEST /* rank */
-
- exitloop:
-
+  free(wdata);
+  free(rank_sum);
+  free(rank_ts);
+  free(samples);
+  free(lat);
   assert(H5Pclose(lcpl) >= 0);
   assert(H5Pclose(dxpl) >= 0);
   assert(H5Pclose(dapl) >= 0);
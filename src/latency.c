@@ -0,0 +1,134 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#include "latency.h"
+
+#include <assert.h>
+#include <string.h>
+
+/* p50, p90, p99, p99.9, and max */
+const double lat_pct[LAT_NPCT] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+/*
+ *
+ * Map a value [ns] to its bucket and a bucket to its largest value
+ *
+ */
+
+static unsigned int bucket_index(uint64_t ns)
+{
+  unsigned int e = 0;
+
+  if (ns < LAT_SUB_COUNT)
+    return (unsigned int) ns;
+
+  while ((ns >> e) > 1)
+    ++e;
+
+  if (e > LAT_MAX_EXP)
+    return LAT_BUCKETS - 1;
+
+  return (e - LAT_SUB_BITS + 1)*LAT_SUB_COUNT +
+    (unsigned int)((ns >> (e - LAT_SUB_BITS)) - LAT_SUB_COUNT);
+}
+
+static uint64_t bucket_upper(unsigned int idx)
+{
+  unsigned int e, m;
+
+  if (idx < LAT_SUB_COUNT)
+    return (uint64_t) idx;
+
+  e = idx/LAT_SUB_COUNT + LAT_SUB_BITS - 1;
+  m = idx%LAT_SUB_COUNT;
+
+  return ((uint64_t)(LAT_SUB_COUNT + m + 1) << (e - LAT_SUB_BITS)) - 1;
+}
+
+void latency_reset(latency* plat)
+{
+  memset(plat, 0, sizeof(latency));
+}
+
+void latency_record(latency* plat, h5d_op op, double seconds)
+{
+  uint64_t ns = (seconds > 0.0) ? (uint64_t)(seconds*1.0e9) : 0;
+
+  assert(op < OP_COUNT);
+  ++plat->count[op][bucket_index(ns)];
+  if (ns > plat->max[op])
+    plat->max[op] = ns;
+}
+
+/*
+ *
+ * Merge the histograms of all ranks in comm on root
+ *
+ */
+
+void latency_reduce(const latency* in, latency* out, int root, MPI_Comm comm)
+{
+  MPI_Reduce(in->count, out->count, OP_COUNT*LAT_BUCKETS, MPI_UINT64_T,
+             MPI_SUM, root, comm);
+  MPI_Reduce(in->max, out->max, OP_COUNT, MPI_UINT64_T,
+             MPI_MAX, root, comm);
+}
+
+uint64_t latency_count(const latency* plat, h5d_op op)
+{
+  uint64_t result = 0;
+  unsigned int i;
+
+  for (i = 0; i < LAT_BUCKETS; ++i)
+    result += plat->count[op][i];
+
+  return result;
+}
+
+/*
+ *
+ * The q-th quantile [s] of an operation's latency (0 if nothing was recorded)
+ *
+ */
+
+double latency_percentile(const latency* plat, h5d_op op, double q)
+{
+  uint64_t total, target, cum = 0, ns;
+  unsigned int i;
+
+  total = latency_count(plat, op);
+  if (total == 0)
+    return 0.0;
+
+  if (q >= 1.0)
+    return (double)plat->max[op]*1.0e-9;
+
+  target = (uint64_t)(q*(double)total);
+  if ((double)target < q*(double)total)
+    ++target;
+  if (target == 0)
+    target = 1;
+
+  for (i = 0; i < LAT_BUCKETS; ++i)
+    {
+      cum += plat->count[op][i];
+      if (cum >= target)
+        break;
+    }
+
+  ns = bucket_upper(i);
+  if (ns > plat->max[op])
+    ns = plat->max[op];
+
+  return (double)ns*1.0e-9;
+}
@@ -0,0 +1,67 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <mpi.h>
+
+#include <stdint.h>
+
+/*
+ * Log-bucketed (HDR-style) latency histograms. Values are recorded in
+ * nanoseconds. Below 2^LAT_SUB_BITS ns the buckets are linear, above that
+ * each power of two is split into 2^LAT_SUB_BITS sub-buckets, which bounds
+ * the relative error of a reported percentile by 2^-LAT_SUB_BITS (~3%).
+ */
+
+#define LAT_SUB_BITS  5
+#define LAT_SUB_COUNT (1 << LAT_SUB_BITS)
+#define LAT_MAX_EXP   42 /* 2^42 ns is a little over an hour */
+#define LAT_BUCKETS   ((LAT_MAX_EXP - LAT_SUB_BITS + 2) * LAT_SUB_COUNT)
+
+/* The H5D operations we keep a histogram for */
+
+typedef enum h5d_op
+{
+  OP_CREATE,
+  OP_WRITE,
+  OP_READ,
+  OP_CLOSE,
+  OP_COUNT
+} h5d_op;
+
+/* The percentiles reported for each operation */
+
+#define LAT_NPCT 5
+
+extern const double lat_pct[LAT_NPCT];
+
+typedef struct
+{
+  uint64_t count[OP_COUNT][LAT_BUCKETS];
+  uint64_t max[OP_COUNT];
+} latency;
+
+extern void latency_reset(latency* plat);
+
+extern void latency_record(latency* plat, h5d_op op, double seconds);
+
+extern void latency_reduce(const latency* in, latency* out, int root,
+                           MPI_Comm comm);
+
+extern uint64_t latency_count(const latency* plat, h5d_op op);
+
+extern double latency_percentile(const latency* plat, h5d_op op, double q);
+
+#endif
@@ -0,0 +1,348 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#include "pipeline.h"
+
+#include <mpi.h>
+#include <zlib.h>
+
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The built-in filters and the registered IDs of common plugins */
+
+static const struct
+{
+  const char*  name;
+  H5Z_filter_t id;
+} known_filters[] =
+  {
+    { "gzip",        H5Z_FILTER_DEFLATE },
+    { "deflate",     H5Z_FILTER_DEFLATE },
+    { "shuffle",     H5Z_FILTER_SHUFFLE },
+    { "fletcher32",  H5Z_FILTER_FLETCHER32 },
+    { "szip",        H5Z_FILTER_SZIP },
+    { "nbit",        H5Z_FILTER_NBIT },
+    { "scaleoffset", H5Z_FILTER_SCALEOFFSET },
+    { "bzip2",       307 },
+    { "lzf",         32000 },
+    { "blosc",       32001 },
+    { "lz4",         32004 },
+    { "bitshuffle",  32008 },
+    { "zfp",         32013 },
+    { "zstd",        32015 },
+    { "sz",          32017 },
+    { "sz3",         32024 },
+    { "blosc2",      32026 },
+    { NULL,          0 }
+  };
+
+static int filter_id(const char* name, H5Z_filter_t* id)
+{
+  unsigned int i;
+  char* end;
+  long n;
+
+  for (i = 0; known_filters[i].name != NULL; ++i)
+    if (strcmp(name, known_filters[i].name) == 0)
+      {
+        *id = known_filters[i].id;
+        return 0;
+      }
+
+  n = strtol(name, &end, 0);
+  if (*name == '\0' || *end != '\0' || n < 1 || n > H5Z_FILTER_MAX)
+    return -1;
+  *id = (H5Z_filter_t)n;
+  return 0;
+}
+
+/*
+ *
+ * Split a pipeline into its filters. Returns -1 if it's malformed.
+ *
+ */
+
+int pipeline_parse(const char* spec, filter_spec filters[], unsigned int* count)
+{
+  char buf[256];
+  char *filter, *next;
+
+  *count = 0;
+  if (strcmp(spec, "none") == 0 || spec[0] == '\0')
+    return 0;
+
+  strncpy(buf, spec, sizeof(buf) - 1);
+  buf[sizeof(buf) - 1] = '\0';
+
+  for (filter = buf; filter != NULL; filter = next)
+    {
+      filter_spec* f = &filters[*count];
+      char *value, *end;
+
+      if ((next = strchr(filter, '+')) != NULL)
+        *next++ = '\0';
+      if (*count == MAX_PIPELINE)
+        return -1;
+
+      if ((value = strchr(filter, ':')) != NULL)
+        *value++ = '\0';
+      if (filter_id(filter, &f->id) < 0)
+        return -1;
+
+      f->cd_nelmts = 0;
+      while (value != NULL)
+        {
+          char* sep = strchr(value, ':');
+          if (sep != NULL)
+            *sep++ = '\0';
+          if (f->cd_nelmts == MAX_CD_VALUES)
+            return -1;
+          f->cd_values[f->cd_nelmts++] =
+            (unsigned int) strtoul(value, &end, 0);
+          if (*value == '\0' || *end != '\0')
+            return -1;
+          value = sep;
+        }
+
+      /* deflate defaults to level 6, szip needs its options mask and pixels
+         per block */
+      if (f->id == H5Z_FILTER_DEFLATE && f->cd_nelmts == 0)
+        f->cd_values[f->cd_nelmts++] = 6;
+      if (f->id == H5Z_FILTER_SZIP && f->cd_nelmts != 2)
+        return -1;
+
+      ++*count;
+    }
+
+  return 0;
+}
+
+/* Are all filters of a pipeline available for encoding (and decoding)? */
+
+int pipeline_check(const char* spec)
+{
+  filter_spec filters[MAX_PIPELINE];
+  unsigned int count, i, filter_info;
+
+  if (pipeline_parse(spec, filters, &count) < 0)
+    return -1;
+
+  for (i = 0; i < count; ++i)
+    {
+      /* this loads a plugin, if necessary */
+      if (H5Zfilter_avail(filters[i].id) <= 0)
+        {
+          printf("Filter %d is not available\n", (int)filters[i].id);
+          return -1;
+        }
+      if (H5Zget_filter_info(filters[i].id, &filter_info) < 0 ||
+          !(filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED) ||
+          !(filter_info & H5Z_FILTER_CONFIG_DECODE_ENABLED))
+        {
+          printf("Filter %d can't encode and decode\n", (int)filters[i].id);
+          return -1;
+        }
+    }
+
+  return 0;
+}
+
+void pipeline_apply(const char* spec, hid_t dcpl)
+{
+  filter_spec filters[MAX_PIPELINE];
+  unsigned int count, i;
+
+  assert(pipeline_parse(spec, filters, &count) == 0);
+
+  for (i = 0; i < count; ++i)
+    {
+      if (filters[i].id == H5Z_FILTER_SZIP)
+        assert(H5Pset_szip(dcpl, filters[i].cd_values[0],
+                           filters[i].cd_values[1]) >= 0);
+      else
+        assert(H5Pset_filter(dcpl, filters[i].id, H5Z_FLAG_MANDATORY,
+                             filters[i].cd_nelmts, filters[i].cd_values) >= 0);
+    }
+}
+
+/* Add colon-separated directories to the plugin search path */
+
+void pipeline_plugin_path(const char* paths)
+{
+  char buf[PATH_MAX+1];
+  char *dir, *next;
+
+  strncpy(buf, paths, PATH_MAX);
+  buf[PATH_MAX] = '\0';
+  for (dir = buf; dir != NULL; dir = next)
+    {
+      if ((next = strchr(dir, ':')) != NULL)
+        *next++ = '\0';
+      if (*dir != '\0')
+        assert(H5PLappend(dir) >= 0);
+    }
+}
+
+/*
+ *
+ * Encoding on the application side, for direct chunk writes. We can only
+ * run filters we have an implementation of, which produces the same bytes
+ * as the library's filter: shuffle and deflate (with zlib).
+ *
+ */
+
+int pipeline_encodable(const char* spec)
+{
+  filter_spec filters[MAX_PIPELINE];
+  unsigned int count, i;
+
+  if (pipeline_parse(spec, filters, &count) < 0)
+    return 0;
+
+  for (i = 0; i < count; ++i)
+    if (filters[i].id != H5Z_FILTER_SHUFFLE &&
+        filters[i].id != H5Z_FILTER_DEFLATE)
+      return 0;
+
+  return 1;
+}
+
+/* the largest encoded size of nbytes */
+
+size_t pipeline_bound(const filter_spec filters[], unsigned int count,
+                      size_t nbytes)
+{
+  unsigned int i;
+
+  for (i = 0; i < count; ++i)
+    if (filters[i].id == H5Z_FILTER_DEFLATE)
+      nbytes = (size_t)compressBound((uLong)nbytes);
+
+  return nbytes;
+}
+
+/*
+ *
+ * Encode the first nbytes of buf in place (buf and work hold cap bytes,
+ * see pipeline_bound) and return the encoded size. Like the library, the
+ * shuffle filter moves the k-th bytes of all elements together and leaves
+ * the bytes of a trailing partial element alone.
+ *
+ */
+
+size_t pipeline_encode(const filter_spec filters[], unsigned int count,
+                       size_t elmt_size, unsigned char* buf, size_t nbytes,
+                       unsigned char* work, size_t cap)
+{
+  unsigned char *in = buf, *out = work, *tmp;
+  unsigned int i;
+  size_t n, j, k;
+  uLongf len;
+
+  for (i = 0; i < count; ++i)
+    {
+      if (filters[i].id == H5Z_FILTER_SHUFFLE)
+        {
+          n = nbytes/elmt_size;
+          for (k = 0; k < elmt_size; ++k)
+            for (j = 0; j < n; ++j)
+              out[k*n + j] = in[j*elmt_size + k];
+          memcpy(out + n*elmt_size, in + n*elmt_size, nbytes - n*elmt_size);
+        }
+      else
+        {
+          len = (uLongf)cap;
+          assert(compress2(out, &len, in, (uLong)nbytes,
+                           (int)filters[i].cd_values[0]) == Z_OK);
+          nbytes = (size_t)len;
+        }
+      tmp = in; in = out; out = tmp;
+    }
+
+  if (in != buf)
+    memcpy(buf, in, nbytes);
+
+  return nbytes;
+}
+
+/*
+ *
+ * The time [s] it takes the pipeline to encode a rows x cols block of
+ * doubles in crows x ccols chunks. We write the block to an in-memory file
+ * with and without the pipeline and keep the fastest of a few tries of each,
+ * so that what remains is (mostly) the cost of the filters.
+ *
+ */
+
+#define COST_TRIES 3
+
+double pipeline_cost(const char* spec, const double* buf,
+                     hsize_t rows, hsize_t cols,
+                     hsize_t crows, hsize_t ccols)
+{
+  hid_t fapl, dcpl[2], space, file, dset;
+  hsize_t dims[2], cdims[2];
+  double t, best[2];
+  unsigned int i, k;
+
+  if (strcmp(spec, "none") == 0 || rows*cols == 0)
+    return 0.0;
+
+  dims[0] = rows;
+  dims[1] = cols;
+  cdims[0] = crows < rows ? crows : rows;
+  cdims[1] = ccols < cols ? ccols : cols;
+
+  assert((fapl = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
+  assert(H5Pset_fapl_core(fapl, 1048576, 0) >= 0); /* no backing store */
+  assert((space = H5Screate_simple(2, dims, NULL)) >= 0);
+  for (k = 0; k < 2; ++k)
+    {
+      assert((dcpl[k] = H5Pcreate(H5P_DATASET_CREATE)) >= 0);
+      assert(H5Pset_chunk(dcpl[k], 2, cdims) >= 0);
+      assert(H5Pset_fill_time(dcpl[k], H5D_FILL_TIME_NEVER) >= 0);
+    }
+  pipeline_apply(spec, dcpl[1]);
+
+  best[0] = best[1] = -1.0;
+  for (i = 0; i < COST_TRIES; ++i)
+    for (k = 0; k < 2; ++k)
+      {
+        /* a fresh file per try, which releases the memory of the last */
+        assert((file = H5Fcreate("pipeline-cost.h5", H5F_ACC_TRUNC,
+                                 H5P_DEFAULT, fapl)) >= 0);
+        assert((dset = H5Dcreate(file, "block", H5T_NATIVE_DOUBLE, space,
+                                 H5P_DEFAULT, dcpl[k], H5P_DEFAULT)) >= 0);
+        /* the chunks are filtered on their way out of the chunk cache,
+           at the latest when the dataset is closed */
+        t = -MPI_Wtime();
+        assert(H5Dwrite(dset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL,
+                        H5P_DEFAULT, buf) >= 0);
+        assert(H5Dclose(dset) >= 0);
+        t += MPI_Wtime();
+        assert(H5Fclose(file) >= 0);
+        if (best[k] < 0.0 || t < best[k])
+          best[k] = t;
+      }
+
+  assert(H5Pclose(dcpl[1]) >= 0);
+  assert(H5Pclose(dcpl[0]) >= 0);
+  assert(H5Sclose(space) >= 0);
+  assert(H5Pclose(fapl) >= 0);
+
+  return best[1] > best[0] ? best[1] - best[0] : 0.0;
+}
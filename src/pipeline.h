@@ -0,0 +1,59 @@
+/* hdf5-iotest -- simple I/O performance tester for HDF5
+
+   SPDX-License-Identifier: BSD-3-Clause
+
+   Copyright (C) 2020, The HDF Group
+
+   hdf5-iotest is released under the New BSD license (see COPYING).
+   Go to the project home page for more info:
+
+   https://github.com/HDFGroup/hdf5-iotest
+
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "hdf5.h"
+
+/*
+ * A filter pipeline is written as FILTER[+FILTER...] or none, where a FILTER
+ * is a registered filter name (see pipeline.c) or a numeric filter ID,
+ * followed by its client data values, separated by colons, e.g.,
+ * shuffle+zstd:3 or 32013:1:0:0:1074790400 (ZFP). Filters that aren't built
+ * into the library are loaded as plugins (see H5PLappend).
+ */
+
+#define MAX_PIPELINE  4
+#define MAX_CD_VALUES 8
+
+typedef struct
+{
+  H5Z_filter_t id;
+  size_t       cd_nelmts;
+  unsigned int cd_values[MAX_CD_VALUES];
+} filter_spec;
+
+extern int pipeline_parse(const char* spec, filter_spec filters[],
+                          unsigned int* count);
+
+extern int pipeline_check(const char* spec);
+
+extern void pipeline_apply(const char* spec, hid_t dcpl);
+
+extern void pipeline_plugin_path(const char* paths);
+
+extern int pipeline_encodable(const char* spec);
+
+extern size_t pipeline_bound(const filter_spec filters[], unsigned int count,
+                             size_t nbytes);
+
+extern size_t pipeline_encode(const filter_spec filters[], unsigned int count,
+                              size_t elmt_size, unsigned char* buf,
+                              size_t nbytes, unsigned char* work, size_t cap);
+
+extern double pipeline_cost(const char* spec, const double* buf,
+                            hsize_t rows, hsize_t cols,
+                            hsize_t crows, hsize_t ccols);
+
+#endif
@@ -20,6 +20,28 @@
 #include <stdlib.h>
 #include <string.h>
 
+/*
+ *
+ * Read the selections of several datasets in a single call
+ *
+ */
+
+static void read_multi(size_t count, hid_t dset[], hid_t mtype[],
+                       hid_t mspace[], hid_t fspace[], hid_t dxpl,
+                       void* buf[], time_step* es)
+{
+#if H5_VERSION_GE(1,14,0)
+  if(es != NULL)
+    assert(H5Dread_multi_async(count, dset, mtype, mspace, fspace, dxpl, buf,
+                               es->es_data) >= 0);
+  else
+    assert(H5Dread_multi(count, dset, mtype, mspace, fspace, dxpl, buf) >= 0);
+#else
+  printf("ERROR: multi-dataset I/O requires HDF5 version >= 1.14\n");
+  MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+}
+
 void read_test
 (
  configuration* pconfig,
@@ -34,13 +56,22 @@ void read_test
  hid_t dapl,
  hid_t dxpl,
  double* create_time,
- double* read_time
+ double* read_time,
+ latency* plat,
+ io_stats* pstats
  )
 {
-  unsigned int step_first_flg, strong_scaling_flg;
-  unsigned int istep, iarray;
+  unsigned int step_first_flg, strong_scaling_flg, multi_flg;
+  unsigned int istep, iarray, n;
+  selection_pattern sel;
+  proc_grid grid;
   double *rbuf;
   hid_t mspace;
+  hid_t *mdset = NULL, *mtype = NULL, *mmspace = NULL, *mfspace = NULL;
+  void **mbuf = NULL;
+  double *mrbuf = NULL;
+  double op_time;
+  cc_model ccm;
 
   char path[255];
 
@@ -53,6 +84,7 @@ void read_test
 #ifdef VERIFY_DATA
   /* Extent of the logical 4D array and partition origin/offset */
   size_t d[4], o[4];
+  unsigned int verify_flg;
 
   /*
    * The C-order of an index [i0, i1, i2, i3] in a 4D array of extent
@@ -71,17 +103,49 @@ void read_test
     dims[0] = (hsize_t)my_rows;
     dims[1] = (hsize_t)my_cols;
     mspace = H5Screate_simple(2, dims, dims);
-    assert(H5Sselect_all(mspace) >= 0);
   }
 
+  /* the read pattern may select less of, or a different part of, the arrays */
+  sel = read_selection(pconfig);
+  read_grid(pconfig, &grid);
+  if (my_proc_row >= 0)
+    select_memory(pconfig, mspace, sel);
+  else /* not part of the read grid */
+    assert(H5Sselect_none(mspace) >= 0);
+
+  cc_model_init(&ccm, pconfig);
+
+  /* multi-dataset I/O batches the arrays of a step into one H5Dread_multi */
+  multi_flg = (pconfig->multi_dataset == 1);
+  if (multi_flg)
+    {
+      mdset   = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mtype   = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mmspace = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mfspace = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mbuf    = (void**) malloc(pconfig->arrays*sizeof(void*));
+      /* destination buffers must not overlap */
+      mrbuf   = (double*) calloc(pconfig->arrays*my_rows*my_cols, sizeof(double));
+      for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+        {
+          mtype[iarray]   = H5T_NATIVE_DOUBLE;
+          mmspace[iarray] = mspace;
+          mbuf[iarray]    = mrbuf + (size_t)iarray*my_rows*my_cols;
+        }
+    }
+
 #ifdef VERIFY_DATA
   strong_scaling_flg = (strncmp(pconfig->scaling, "strong", 16) == 0);
 
   d[2] = strong_scaling_flg ? pconfig->rows : pconfig->rows * pconfig->proc_rows;
   d[3] = strong_scaling_flg ? pconfig->cols : pconfig->cols * pconfig->proc_cols;
 
-  o[2] = strong_scaling_flg ? rank * my_rows : my_proc_row * pconfig->rows;
-  o[3] = strong_scaling_flg ? rank * my_cols : my_proc_col * pconfig->cols;
+  /* the reader's block, which may be on a different grid than the writer's */
+  o[2] = my_proc_row * my_rows;
+  o[3] = my_proc_col * my_cols;
+
+  /* only the block patterns read back whole blocks */
+  verify_flg = (sel == SELECT_BLOCK && my_proc_row >= 0);
   if (rank == 0)
     printf("\n\033[1;31m WARNING: Data verification enabled. Timings will be distorted!!!\033[0m\n");
 #endif
@@ -111,24 +175,32 @@ void read_test
         else
 #endif
         assert((dset = H5Dopen(file, "dataset", dapl)) >= 0);
+        cc_model_reset(&ccm);
 
         for (istep = 0; istep < pconfig->steps; ++istep)
           {
             for (iarray = 0; iarray < pconfig->arrays; ++iarray)
               {
+                if (!reads_array(pconfig, istep, iarray))
+                  continue;
                 assert((fspace = H5Dget_space(dset)) >= 0);
                 *create_time -= MPI_Wtime();
-                create_selection(pconfig, fspace, my_proc_row, my_proc_col,
-                                 istep, iarray);
+                create_selection(pconfig, &grid, fspace, my_proc_row, my_proc_col,
+                                 istep, iarray, sel);
                 *create_time += MPI_Wtime();
-                *read_time -= MPI_Wtime();
+                cc_model_access(&ccm, fspace);
+                op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
                 if(es != NULL)
                   assert(H5Dread_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf, es->es_data) >= 0);
                 else
 #endif
                   assert(H5Dread(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf) >= 0);
-                *read_time += MPI_Wtime();
+                op_time += MPI_Wtime();
+                *read_time += op_time;
+                if (es == NULL)
+                  get_mpio_stats(dxpl, 1, pstats);
+                latency_record(plat, OP_READ, op_time);
                 assert(H5Sclose(fspace) >= 0);
 
 #ifdef VERIFY_DATA
@@ -136,7 +208,8 @@ void read_test
                 d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
                 o[0] = step_first_flg ? istep : iarray;
                 o[1] = step_first_flg ? iarray : istep;
-                verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
+                if (verify_flg)
+                  verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
 #endif
               }
 
@@ -157,12 +230,15 @@ void read_test
 #endif
 
           }
+        op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
         if(es != NULL)
           assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
         else
 #endif
           assert(H5Dclose(dset) >= 0);
+        op_time += MPI_Wtime();
+        latency_record(plat, OP_CLOSE, op_time);
       }
 
       break;
@@ -174,38 +250,50 @@ void read_test
               {
                 sprintf(path, "step=%d", istep);
                 assert((dset = H5Dopen(file, path, dapl)) >= 0);
+                cc_model_reset(&ccm);
                 assert((fspace = H5Dget_space(dset)) >= 0);
 
                 for (iarray = 0; iarray < pconfig->arrays; ++iarray)
                   {
+                    if (!reads_array(pconfig, istep, iarray))
+                      continue;
                     *create_time -= MPI_Wtime();
-                    create_selection(pconfig, fspace, my_proc_row,
-                                     my_proc_col, istep, iarray);
+                    create_selection(pconfig, &grid, fspace, my_proc_row,
+                                     my_proc_col, istep, iarray, sel);
                     *create_time += MPI_Wtime();
+                    cc_model_access(&ccm, fspace);
 
-                    *read_time -= MPI_Wtime();
+                    op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
                     if(es != NULL)
                       assert(H5Dread_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf, es->es_data) >= 0);
                     else
 #endif
                       assert(H5Dread(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf) >= 0);
-                    *read_time += MPI_Wtime();
+                    op_time += MPI_Wtime();
+                    *read_time += op_time;
+                    if (es == NULL)
+                      get_mpio_stats(dxpl, 1, pstats);
+                    latency_record(plat, OP_READ, op_time);
 
 #ifdef VERIFY_DATA
                     d[0] = pconfig->steps; d[1] = pconfig->arrays;
                     o[0] = istep; o[1] = iarray;
-                    verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
+                    if (verify_flg)
+                      verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
 #endif
                   }
 
                 assert(H5Sclose(fspace) >= 0);
+                op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
                 if(es != NULL)
                   assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
                 else
 #endif
                   assert(H5Dclose(dset) >= 0);
+                op_time += MPI_Wtime();
+                latency_record(plat, OP_CLOSE, op_time);
 
                 if (pconfig->delay.enable == 1) {
                   if (istep != pconfig->steps - 1) { // no sleep after the last es
@@ -227,38 +315,105 @@ void read_test
           {
             for (istep = 0; istep < pconfig->steps; ++istep)
               {
-                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                if (multi_flg) /* all arrays of the step in one H5Dread_multi */
                   {
-                    sprintf(path, "array=%d", iarray);
-                    assert((dset = H5Dopen(file, path, dapl)) >= 0);
-                    assert((fspace = H5Dget_space(dset)) >= 0);
-                    *create_time -= MPI_Wtime();
-                    create_selection(pconfig, fspace, my_proc_row,
-                                     my_proc_col, istep, iarray);
-                    *create_time += MPI_Wtime();
-
-                    *read_time -= MPI_Wtime();
+                    n = 0;
+                    for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                      {
+                        if (!reads_array(pconfig, istep, iarray))
+                          continue;
+                        sprintf(path, "array=%d", iarray);
+                        assert((mdset[n] = H5Dopen(file, path, dapl)) >= 0);
+                        cc_model_reset(&ccm);
+                        assert((mfspace[n] = H5Dget_space(mdset[n])) >= 0);
+                        *create_time -= MPI_Wtime();
+                        create_selection(pconfig, &grid, mfspace[n], my_proc_row,
+                                         my_proc_col, istep, iarray, sel);
+                        *create_time += MPI_Wtime();
+                        cc_model_access(&ccm, mfspace[n]);
+                        ++n;
+                      }
+
+                    op_time = -MPI_Wtime();
+                    read_multi(n, mdset, mtype, mmspace, mfspace, dxpl, mbuf, es);
+                    op_time += MPI_Wtime();
+                    *read_time += op_time;
+                    if (es == NULL)
+                      get_mpio_stats(dxpl, 1, pstats);
+                    latency_record(plat, OP_READ, op_time);
+
+                    n = 0;
+                    for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                      {
+                        if (!reads_array(pconfig, istep, iarray))
+                          continue;
+                        assert(H5Sclose(mfspace[n]) >= 0);
+                        op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
-                    if(es != NULL)
-                      assert(H5Dread_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf, es->es_data) >= 0);
-                    else
+                        if(es != NULL)
+                          assert(H5Dclose_async(mdset[n], es->es_meta_data) >= 0);
+                        else
 #endif
-                      assert(H5Dread(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf) >= 0);
-                    *read_time += MPI_Wtime();
+                          assert(H5Dclose(mdset[n]) >= 0);
+                        op_time += MPI_Wtime();
+                        latency_record(plat, OP_CLOSE, op_time);
 
-                    assert(H5Sclose(fspace) >= 0);
+#ifdef VERIFY_DATA
+                        d[0] = pconfig->arrays; d[1] = pconfig->steps;
+                        o[0] = iarray; o[1] = istep;
+                        if (verify_flg)
+                          verify_read_buffer((double*)mbuf[n], &my_rows, &my_cols, d, o);
+#endif
+                        ++n;
+                      }
+                  }
+                else
+                  {
+                    for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                      {
+                        if (!reads_array(pconfig, istep, iarray))
+                          continue;
+                        sprintf(path, "array=%d", iarray);
+                        assert((dset = H5Dopen(file, path, dapl)) >= 0);
+                        cc_model_reset(&ccm);
+                        assert((fspace = H5Dget_space(dset)) >= 0);
+                        *create_time -= MPI_Wtime();
+                        create_selection(pconfig, &grid, fspace, my_proc_row,
+                                         my_proc_col, istep, iarray, sel);
+                        *create_time += MPI_Wtime();
+                        cc_model_access(&ccm, fspace);
+
+                        op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
-                    if(es != NULL)
-                      assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
-                    else
+                        if(es != NULL)
+                          assert(H5Dread_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf, es->es_data) >= 0);
+                        else
 #endif
-                      assert(H5Dclose(dset) >= 0);
+                          assert(H5Dread(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf) >= 0);
+                        op_time += MPI_Wtime();
+                        *read_time += op_time;
+                        if (es == NULL)
+                          get_mpio_stats(dxpl, 1, pstats);
+                        latency_record(plat, OP_READ, op_time);
+
+                        assert(H5Sclose(fspace) >= 0);
+                        op_time = -MPI_Wtime();
+#if H5_VERSION_GE(1,14,0)
+                        if(es != NULL)
+                          assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
+                        else
+#endif
+                          assert(H5Dclose(dset) >= 0);
+                        op_time += MPI_Wtime();
+                        latency_record(plat, OP_CLOSE, op_time);
 
 #ifdef VERIFY_DATA
-                    d[0] = pconfig->arrays; d[1] = pconfig->steps;
-                    o[0] = iarray; o[1] = istep;
-                    verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
+                        d[0] = pconfig->arrays; d[1] = pconfig->steps;
+                        o[0] = iarray; o[1] = istep;
+                        if (verify_flg)
+                          verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
 #endif
+                      }
                   }
 
                 if (pconfig->delay.enable == 1) {
@@ -283,46 +438,120 @@ void read_test
       {
         for (istep = 0; istep < pconfig->steps; ++istep)
           {
-            for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+            if (multi_flg) /* all arrays of the step in one H5Dread_multi */
               {
-                /* group per step or array */
-                sprintf(path, (step_first_flg ?
-                               "step=%d/array=%d" : "array=%d/step=%d"),
-                        (step_first_flg ? istep : iarray),
-                        (step_first_flg ? iarray : istep));
+                n = 0;
+                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                  {
+                    if (!reads_array(pconfig, istep, iarray))
+                      continue;
+                    /* group per step or array */
+                    sprintf(path, (step_first_flg ?
+                                   "step=%d/array=%d" : "array=%d/step=%d"),
+                            (step_first_flg ? istep : iarray),
+                            (step_first_flg ? iarray : istep));
+                    assert((mdset[n] = H5Dopen(file, path, dapl)) >= 0);
+                    cc_model_reset(&ccm);
+                    assert((mfspace[n] = H5Dget_space(mdset[n])) >= 0);
+                    *create_time -= MPI_Wtime();
+                    create_selection(pconfig, &grid, mfspace[n], my_proc_row,
+                                     my_proc_col, istep, iarray, sel);
+                    *create_time += MPI_Wtime();
+                    cc_model_access(&ccm, mfspace[n]);
+                    ++n;
+                  }
 
-                assert((dset = H5Dopen(file, path, dapl)) >= 0);
+                op_time = -MPI_Wtime();
+                read_multi(n, mdset, mtype, mmspace, mfspace, dxpl, mbuf, es);
+                op_time += MPI_Wtime();
+                *read_time += op_time;
+                if (es == NULL)
+                  get_mpio_stats(dxpl, 1, pstats);
+                latency_record(plat, OP_READ, op_time);
 
-                assert((fspace = H5Dget_space(dset)) >= 0);
-                *create_time -= MPI_Wtime();
-                create_selection(pconfig, fspace, my_proc_row, my_proc_col,
-                                 istep, iarray);
-                *create_time += MPI_Wtime();
+                n = 0;
+                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                  {
+                    if (!reads_array(pconfig, istep, iarray))
+                      continue;
+                    assert(H5Sclose(mfspace[n]) >= 0);
+                    op_time = -MPI_Wtime();
+#if H5_VERSION_GE(1,14,0)
+                    if(es != NULL)
+                      assert(H5Dclose_async(mdset[n], es->es_meta_data) >= 0);
+                    else
+#endif
+                      assert(H5Dclose(mdset[n]) >= 0);
+                    op_time += MPI_Wtime();
+                    latency_record(plat, OP_CLOSE, op_time);
+
+#ifdef VERIFY_DATA
+                    d[0] = step_first_flg ? pconfig->steps : pconfig->arrays;
+                    d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
+                    o[0] = step_first_flg ? istep : iarray;
+                    o[1] = step_first_flg ? iarray : istep;
+                    if (verify_flg)
+                      verify_read_buffer((double*)mbuf[n], &my_rows, &my_cols, d, o);
+#endif
+                    ++n;
+                  }
+              }
+            else
+              {
+                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                  {
+                    if (!reads_array(pconfig, istep, iarray))
+                      continue;
+                    /* group per step or array */
+                    sprintf(path, (step_first_flg ?
+                                   "step=%d/array=%d" : "array=%d/step=%d"),
+                            (step_first_flg ? istep : iarray),
+                            (step_first_flg ? iarray : istep));
+
+                    assert((dset = H5Dopen(file, path, dapl)) >= 0);
+
+                    cc_model_reset(&ccm);
+
+                    assert((fspace = H5Dget_space(dset)) >= 0);
+                    *create_time -= MPI_Wtime();
+                    create_selection(pconfig, &grid, fspace, my_proc_row, my_proc_col,
+                                     istep, iarray, sel);
+                    *create_time += MPI_Wtime();
+                    cc_model_access(&ccm, fspace);
 
-                *read_time -= MPI_Wtime();
+                    op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
-                if(es != NULL)
-                  assert(H5Dread_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf, es->es_data) >= 0);
-                else
+                    if(es != NULL)
+                      assert(H5Dread_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf, es->es_data) >= 0);
+                    else
 #endif
-                  assert(H5Dread(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf) >= 0);
-                *read_time += MPI_Wtime();
+                      assert(H5Dread(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, rbuf) >= 0);
+                    op_time += MPI_Wtime();
+                    *read_time += op_time;
+                    if (es == NULL)
+                      get_mpio_stats(dxpl, 1, pstats);
+                    latency_record(plat, OP_READ, op_time);
 
-                assert(H5Sclose(fspace) >= 0);
+                    assert(H5Sclose(fspace) >= 0);
+                    op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
-                if(es != NULL)
-                  assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
-                else
+                    if(es != NULL)
+                      assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
+                    else
 #endif
-                  assert(H5Dclose(dset) >= 0);
+                      assert(H5Dclose(dset) >= 0);
+                    op_time += MPI_Wtime();
+                    latency_record(plat, OP_CLOSE, op_time);
 
 #ifdef VERIFY_DATA
-                d[0] = step_first_flg ? pconfig->steps : pconfig->arrays;
-                d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
-                o[0] = step_first_flg ? istep : iarray;
-                o[1] = step_first_flg ? iarray : istep;
-                verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
+                    d[0] = step_first_flg ? pconfig->steps : pconfig->arrays;
+                    d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
+                    o[0] = step_first_flg ? istep : iarray;
+                    o[1] = step_first_flg ? iarray : istep;
+                    if (verify_flg)
+                      verify_read_buffer(rbuf, &my_rows, &my_cols, d, o);
 #endif
+                  }
               }
 
             if (pconfig->delay.enable == 1) {
@@ -346,6 +575,12 @@ void read_test
       break;
     }
 
+  if (es == NULL)
+    {
+      get_page_buffer_stats(pconfig, file, pstats);
+      get_mdc_stats(file, 1, pstats);
+    }
+
 #if H5_VERSION_GE(1,14,0)
   if(es != NULL) {
     if (pconfig->async == 1) {
@@ -359,6 +594,20 @@ void read_test
 #endif
     assert(H5Fclose(file) >= 0);
 
+  pstats->read_chunk_hits   += ccm.hits;
+  pstats->read_chunk_misses += ccm.misses;
+  pstats->read_bytes        += ccm.bytes;
+  cc_model_free(&ccm);
+
   assert(H5Sclose(mspace) >= 0);
   free(rbuf);
+  if (multi_flg)
+    {
+      free(mdset);
+      free(mtype);
+      free(mmspace);
+      free(mfspace);
+      free(mbuf);
+      free(mrbuf);
+    }
 }
@@ -15,6 +15,7 @@
 #define READ_TEST_H
 
 #include "configuration.h"
+#include "utils.h"
 #include "hdf5.h"
 
 extern void read_test
@@ -31,7 +32,9 @@ extern void read_test
  hid_t dapl,
  hid_t dxpl,
  double* create_time,
- double* read_time
+ double* read_time,
+ latency* plat,
+ io_stats* pstats
  );
 
 #endif
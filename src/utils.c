@@ -13,6 +13,10 @@
 
 #include "utils.h"
 
+#include "dataset.h"
+#include "generator.h"
+
+#include <math.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
@@ -22,8 +26,146 @@
 
 char* async[2] = { "false", "true" };
 
+#define GIB (1024.0*1024.0*1024.0)
+
+/* The column names of the values in rep_stats */
+
+static const char* timing_names[NTIMINGS] = {
+  "wall", "write-phase-min", "write-phase-max", "creat-min", "creat-max",
+  "write-min", "write-max", "read-phase-min", "read-phase-max",
+  "read-min", "read-max"
+};
+
+/* The column names of the values in rank_timing */
+
+static const char* phase_names[NPHASES] = {
+  "write-phase", "creat", "write", "read-phase", "read"
+};
+
+/* The per-rank timings go next to the CSV file, foo.csv -> foo-ranks.csv */
+
+void rank_file_name(const char* fname, char* rname, size_t len)
+{
+  size_t n = strlen(fname);
+
+  if (n >= 4 && strcmp(fname + n - 4, ".csv") == 0)
+    n -= 4;
+  snprintf(rname, len, "%.*s-ranks.csv", (int)n, fname);
+}
+
+/* The effective MPI-IO hints of the cases go to foo-hints.csv */
+
+void hints_file_name(const char* fname, char* hname, size_t len)
+{
+  size_t n = strlen(fname);
+
+  if (n >= 4 && strcmp(fname + n - 4, ".csv") == 0)
+    n -= 4;
+  snprintf(hname, len, "%.*s-hints.csv", (int)n, fname);
+}
+
+/* The tuner's best case goes next to the CSV file, foo.csv -> foo-tuned.ini */
+
+void tuned_file_name(const char* fname, char* tname, size_t len)
+{
+  size_t n = strlen(fname);
+
+  if (n >= 4 && strcmp(fname + n - 4, ".csv") == 0)
+    n -= 4;
+  snprintf(tname, len, "%.*s-tuned.ini", (int)n, fname);
+}
+
+/*
+ *
+ * The MPI info object for the hints of a case (MPI_INFO_NULL for none).
+ * Sizes with a K, M, or G suffix are passed on in bytes.
+ *
+ */
+
+void create_mpi_info(const configuration* pconfig, MPI_Info* info)
+{
+  char buf[AXIS_VALUE_LEN], num[32];
+  char *term, *value, *next;
+  unsigned long long size;
+  size_t len;
+
+  *info = MPI_INFO_NULL;
+  if (strcmp(pconfig->mpi_hints, "none") == 0)
+    return;
+
+  MPI_Info_create(info);
+  strncpy(buf, pconfig->mpi_hints, sizeof(buf));
+  for (term = buf; term != NULL; term = next)
+    {
+      if ((next = strchr(term, '+')) != NULL)
+        *next++ = '\0';
+      value = strchr(term, '=');
+      *value++ = '\0';
+      len = strlen(value);
+      if (len > 1 && strchr("kKmMgG", value[len - 1]) != NULL &&
+          strspn(value, "0123456789") == len - 1 &&
+          parse_size(value, &size) == 0)
+        {
+          snprintf(num, sizeof(num), "%llu", size);
+          value = num;
+        }
+      MPI_Info_set(*info, term, value);
+    }
+}
+
+/*
+ *
+ * Log the hints that MPI-IO applies to a case's file (with the case's
+ * communicator and requested hints), which is opened for that. All ranks of
+ * comm must call this, and its rank 0 writes a KEY,VALUE line per hint.
+ *
+ */
+
+void log_mpi_hints(const char* csv_file, int icase, MPI_Comm comm,
+                   const char* hdf5_filename, MPI_Info info)
+{
+  MPI_File fh;
+  MPI_Info used;
+  char hname[PATH_MAX+16], key[MPI_MAX_INFO_KEY+1], value[1024];
+  int rank, nkeys, i, flag;
+  FILE* fptr;
+
+  MPI_Comm_rank(comm, &rank);
+  if (MPI_File_open(comm, hdf5_filename, MPI_MODE_RDONLY, info, &fh)
+      != MPI_SUCCESS)
+    return;
+  MPI_File_get_info(fh, &used);
+  MPI_File_close(&fh);
+
+  if (rank == 0)
+    {
+      hints_file_name(csv_file, hname, sizeof(hname));
+      assert((fptr = fopen(hname, "a")) != NULL);
+      MPI_Info_get_nkeys(used, &nkeys);
+      for (i = 0; i < nkeys; ++i)
+        {
+          MPI_Info_get_nthkey(used, i, key);
+          MPI_Info_get(used, key, sizeof(value) - 1, value, &flag);
+          if (flag)
+            fprintf(fptr, "%d,%s,%s\n", icase, key, value);
+        }
+      fclose(fptr);
+    }
+  MPI_Info_free(&used);
+}
+
+/* The VFD and batching of a case, appended to the I/O mode */
+
+static const char* io_suffix(const configuration* pconfig)
+{
+  if (pconfig->subfiling)
+    return pconfig->multi_dataset ? "-subfiling-multi" : "-subfiling";
+  return pconfig->multi_dataset ? "-multi" : "";
+}
+
 void create_output_file(const char* fname)
 {
+  unsigned int i;
   FILE *fptr = fopen(fname, "w");
   assert(fptr != NULL);
   fprintf(fptr, "steps,arrays,rows,cols,scaling,proc-rows,proc-cols,"
@@ -33,19 +175,137 @@ void create_output_file(const char* fname)
           "creat-min [s],creat-max [s],"
           "write-min [s],write-max [s],"
           "read-phase-min [s],read-phase-max [s],"
-          "read-min [s],read-max [s]\n");
+          "read-min [s],read-max [s],"
+          "creat-op-p50 [s],creat-op-p90 [s],creat-op-p99 [s],"
+          "creat-op-p99.9 [s],creat-op-max [s],"
+          "write-op-p50 [s],write-op-p90 [s],write-op-p99 [s],"
+          "write-op-p99.9 [s],write-op-max [s],"
+          "read-op-p50 [s],read-op-p90 [s],read-op-p99 [s],"
+          "read-op-p99.9 [s],read-op-max [s],"
+          "close-op-p50 [s],close-op-p90 [s],close-op-p99 [s],"
+          "close-op-p99.9 [s],close-op-max [s],"
+          "chunk-cache-nslots,chunk-cache-nbytes [B],chunk-cache-w0,"
+          "chunk-bytes [B],write-chunk-hit-rate,read-chunk-hit-rate,"
+          "chunk-shape,chunk-dims,"
+          "async-buffers,compute [s],async-wait [s],io-overlap,"
+          "subfiling-stripe-size [B],subfiling-ioc-per-node,repetitions");
+  for (i = 0; i < NTIMINGS; ++i)
+    fprintf(fptr, ",%s-stddev [s],%s-median [s],%s-ci95 [s]",
+            timing_names[i], timing_names[i], timing_names[i]);
+  for (i = 0; i < NPHASES; ++i)
+    fprintf(fptr, ",%s-max/mean,%s-rank-stddev [s],%s-argmax-rank,"
+            "%s-argmax-host", phase_names[i], phase_names[i], phase_names[i],
+            phase_names[i]);
+  fprintf(fptr, ",write-bytes [B],read-bytes [B],"
+          "write-eff [GiB/s],write-raw [GiB/s],"
+          "read-eff [GiB/s],read-raw [GiB/s],"
+          "write-eff-rank [MiB/s],write-raw-rank [MiB/s],"
+          "read-eff-rank [MiB/s],read-raw-rank [MiB/s],"
+          "creat-ops [1/s],write-ops [1/s],read-ops [1/s],read-pattern,"
+          "read-proc-rows,read-proc-cols,data-generator,data-entropy-bits,"
+          "filter,storage-bytes [B],compression-ratio,"
+          "filter-time [s],transfer-time [s],filter [GiB/s],"
+          "compressed [GiB/s],uncompressed [GiB/s],chunk-write,"
+          "threads-per-rank,write-raw-thread [MiB/s],lock-wait [s],"
+          "lock-wait-share,file-space-page-size [B],page-buffer-size [B],"
+          "page-meta-hits,page-meta-misses,page-raw-hits,page-raw-misses,"
+          "mdc-config,evict-on-close,mdc-image,"
+          "write-mdc-hit-rate,write-mdc-max-size [B],write-mdc-size [B],"
+          "write-mdc-entries,read-mdc-hit-rate,read-mdc-max-size [B],"
+          "read-mdc-size [B],read-mdc-entries,"
+          "attributes,attribute-size [B],attr-phase-change,track-times,"
+          "no-attrs-hint,objects,objects [1/s],files,ranks-per-file,"
+          "mpi-hints,write-mpio-no-coll,write-mpio-chunk-ind,"
+          "write-mpio-chunk-coll,write-mpio-chunk-mixed,"
+          "write-mpio-contig-coll,write-mpio-link-chunk,"
+          "write-mpio-multi-chunk,write-mpio-causes,read-mpio-no-coll,"
+          "read-mpio-chunk-ind,read-mpio-chunk-coll,read-mpio-chunk-mixed,"
+          "read-mpio-contig-coll,read-mpio-link-chunk,read-mpio-multi-chunk,"
+          "read-mpio-causes\n");
   fclose(fptr);
+
+  {
+    char rname[PATH_MAX+16];
+    rank_file_name(fname, rname, sizeof(rname));
+    fptr = fopen(rname, "w");
+    assert(fptr != NULL);
+    fprintf(fptr, "case,rank,host,proc-row,proc-col");
+    for (i = 0; i < NPHASES; ++i)
+      fprintf(fptr, ",%s [s]", phase_names[i]);
+    fprintf(fptr, "\n");
+    fclose(fptr);
+
+    hints_file_name(fname, rname, sizeof(rname));
+    fptr = fopen(rname, "w");
+    assert(fptr != NULL);
+    fprintf(fptr, "case,hint,value\n");
+    fclose(fptr);
+  }
+}
+
+/*
+ *
+ * The causes of the non-collective transfers of a phase as CAUSE:COUNT terms
+ * joined by '+', or "-" if there were none
+ *
+ */
+
+static void mpio_causes_str(const timings* pts, unsigned int phase,
+                            char* str, size_t len)
+{
+  /* the bits of H5D_mpio_no_collective_cause_t */
+  static const char* names[] = {
+    "set-independent", "type-conversion", "data-transforms",
+    "mpi-opt-types-disabled", "not-simple-dataspace",
+    "not-contiguous-or-chunked", "parallel-filtered-writes-disabled",
+    "error-checking-collective", "no-selection-io"
+  };
+  size_t pos = 0;
+  unsigned int i;
+
+  str[0] = '\0';
+  for (i = 0; i < MPIO_CAUSES && pos < len; ++i)
+    {
+      if (pts->mpio_cause[phase][i] == 0.0)
+        continue;
+      if (i < sizeof(names)/sizeof(*names))
+        pos += (size_t)snprintf(str + pos, len - pos, "%s%s:%.0f",
+                                pos > 0 ? "+" : "", names[i],
+                                pts->mpio_cause[phase][i]);
+      else
+        pos += (size_t)snprintf(str + pos, len - pos, "%s0x%x:%.0f",
+                                pos > 0 ? "+" : "", 1u << i,
+                                pts->mpio_cause[phase][i]);
+    }
+  if (pos == 0)
+    snprintf(str, len, "-");
+}
+
+/* The size of an HDF5 file [B] */
+
+static hsize_t file_size(const char* fname, hid_t fapl)
+{
+  hid_t file;
+  hsize_t nbytes;
+
+  assert((file = H5Fopen(fname, H5F_ACC_RDONLY, fapl)) >= 0);
+  assert(H5Fget_filesize(file, &nbytes) >= 0);
+  assert(H5Fclose(file) >= 0);
+  return nbytes;
 }
 
 void print_results
 (
  configuration* pconfig,
  char*          hdf5_filename,
- double         wall_time,
- timings*       pts
+ const rep_stats* prs,
+ timings*       pts,
+ const rank_timing* pranks,
+ int            size,
+ int            icase
  )
 {
-  hid_t file;
+  double wall_time = prs->mean[0];
   hsize_t fsize,fsize_units;
 
   unsigned majnum, minnum, relnum;
@@ -82,16 +342,38 @@ void print_results
   else 
     {
       hid_t fapl;
+      char fname[PATH_MAX+32];
+      unsigned int ifile, nfiles = file_groups(pconfig, size);
+      int r;
+
       assert((fapl = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
       assert(H5Pset_fapl_mpio(fapl, MPI_COMM_SELF, MPI_INFO_NULL) >= 0);
-      assert((file = H5Fopen(hdf5_filename, H5F_ACC_RDONLY, fapl)) >= 0);
-      assert(H5Fget_filesize(file, &fsize) >= 0);
+      /* with a file per group of ranks, the total size of the files */
+      fsize = 0;
+      for (ifile = 0; ifile < nfiles; ++ifile)
+        {
+          if (nfiles > 1)
+            group_file_name(hdf5_filename, (int)ifile, fname, sizeof(fname));
+          else
+            snprintf(fname, sizeof(fname), "%s", hdf5_filename);
+          fsize += file_size(fname, fapl);
+        }
+      /* the virtual layout's data is in the ranks' source files */
+      if (strncmp(pconfig->layout, "virtual", 16) == 0)
+        for (r = 0; r < size; ++r)
+          {
+            source_file_name(hdf5_filename, r, fname, sizeof(fname));
+            fsize += file_size(fname, fapl);
+          }
       assert(H5Pclose(fapl) >= 0);
-      assert(H5Fclose(file) >= 0);
     }
 
   /* write summary to the console */
-  printf("Wall clock  [s]:\t\t%.2f\n", wall_time);
+  if (prs->reps > 1)
+    printf("Wall clock  [s]:\t\t%.2f +/- %.2f (%u repetitions)\n",
+           wall_time, prs->ci95[0], prs->reps);
+  else
+    printf("Wall clock  [s]:\t\t%.2f\n", wall_time);
 
   static const char *UNIT[] = { "B", "kiB", "MiB", "GiB", "TiB", "PiB", "EiB" };
   hsize_t cnt = 0;
@@ -103,13 +385,70 @@ void print_results
     cnt++;
   }
   printf("File size [%s]:\t\t%.1f\n", UNIT[cnt], (float)fsize_units + (float)rem / 1024.0);
+  printf("Write [GiB/s]:\t\t\t%.3f (raw %.3f)\n",
+         pts->write_bw_eff, pts->write_bw_raw);
+  printf("Read [GiB/s]:\t\t\t%.3f (raw %.3f)\n",
+         pts->read_bw_eff, pts->read_bw_raw);
+  if (pts->filter_time > 0.0)
+    printf("Compression:\t\t\t%.2fx, filter %.3f GiB/s, %.1f%% of write\n",
+           pts->compression_ratio, pts->filter_bw,
+           pts->max_write_phase > 0.0 ?
+           100.0*pts->filter_time/pts->max_write_phase : 0.0);
+  printf("Objects [1/s]:\t\t\t%.1f (%.0f objects)\n",
+         pts->object_rate, pts->objects);
+  {
+    double total[2] = { 0.0, 0.0 };
+    unsigned int i, j;
+
+    for (i = 0; i < 2; ++i)
+      for (j = 0; j < MPIO_IO_MODES; ++j)
+        total[i] += pts->mpio_io_mode[i][j];
+    if (total[0] + total[1] > 0.0)
+      {
+        char causes[2][256];
+
+        for (i = 0; i < 2; ++i)
+          mpio_causes_str(pts, i, causes[i], sizeof(causes[i]));
+        /* fully collective transfers out of those requested as collective */
+        printf("Collective I/O:\t\t\twrite %.0f/%.0f (%s), "
+               "read %.0f/%.0f (%s)\n",
+               pts->mpio_io_mode[0][H5D_MPIO_CHUNK_COLLECTIVE] +
+               pts->mpio_io_mode[0][H5D_MPIO_CONTIGUOUS_COLLECTIVE],
+               total[0], causes[0],
+               pts->mpio_io_mode[1][H5D_MPIO_CHUNK_COLLECTIVE] +
+               pts->mpio_io_mode[1][H5D_MPIO_CONTIGUOUS_COLLECTIVE],
+               total[1], causes[1]);
+      }
+  }
 
   { /* write results to the CSV file */
+    unsigned int op, i;
+    proc_grid rgrid;
+    unsigned long long chunk_bytes = 0;
+    char cdims_str[96] = "-";
     FILE *fptr = fopen(pconfig->csv_file, "a");
     assert(fptr != NULL);
-    fprintf(fptr, "%d,%d,%ld,%ld,%s,%d,%d,%s,%d,%s,%llu,%llu,%llu,%s,%s,%s,%s,%s,"
+
+    read_grid(pconfig, &rgrid);
+
+    if (strncmp(pconfig->layout, "chunked", 16) == 0)
+      {
+        hsize_t cdims[H5S_MAX_RANK];
+        chunk_dims(pconfig, cdims);
+        chunk_bytes = sizeof(double);
+        cdims_str[0] = '\0';
+        for (i = 0; i < pconfig->rank; ++i)
+          {
+            size_t len = strlen(cdims_str);
+            chunk_bytes *= (unsigned long long)cdims[i];
+            snprintf(cdims_str + len, sizeof(cdims_str) - len, "%s%llu",
+                     i > 0 ? "x" : "", (unsigned long long)cdims[i]);
+          }
+      }
+
+    fprintf(fptr, "%d,%d,%ld,%ld,%s,%d,%d,%s,%d,%s,%llu,%llu,%llu,%s,%s,%s,%s%s,%s,"
             "%.4f,%.0f,%.4f,%.4f,%.4f,%.4f,"
-            "%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+            "%.4f,%.4f,%.4f,%.4f,%.4f,%.4f",
             pconfig->steps, pconfig->arrays, pconfig->rows, pconfig->cols,
             pconfig->scaling, pconfig->proc_rows, pconfig->proc_cols,
             pconfig->slowest_dimension, pconfig->rank, version,
@@ -117,12 +456,133 @@ void print_results
             (unsigned long long)pconfig->alignment_threshold,
 	    (unsigned long long)pconfig->meta_block_size,
             pconfig->layout, pconfig->fill_values, pconfig->libver_bound_low,
-            pconfig->mpi_io, async[pconfig->async], wall_time, (double)fsize,
+            pconfig->mpi_io, io_suffix(pconfig),
+            async[pconfig->async], wall_time, (double)fsize,
             pts->min_write_phase, pts->max_write_phase,
             pts->min_create_time, pts->max_create_time,
             pts->min_write_time, pts->max_write_time,
             pts->min_read_phase, pts->max_read_phase,
             pts->min_read_time, pts->max_read_time);
+    for (op = 0; op < OP_COUNT; ++op)
+      for (i = 0; i < LAT_NPCT; ++i)
+        fprintf(fptr, ",%.6f", pts->op_latency[op][i]);
+    fprintf(fptr, ",%llu,%llu,%.2f,%llu,%.4f,%.4f,%s,%s,%u,%.4f,%.4f,%.4f",
+            (unsigned long long)pconfig->chunk_cache_nslots,
+            (unsigned long long)pconfig->chunk_cache_nbytes,
+            pconfig->chunk_cache_w0, chunk_bytes,
+            pts->write_chunk_hit_rate, pts->read_chunk_hit_rate,
+            pconfig->chunk_shape, cdims_str,
+            pconfig->async ? pconfig->async_buffers : 0,
+            pts->compute_time, pts->async_wait_time, pts->io_overlap);
+    if (pconfig->subfiling)
+      fprintf(fptr, ",%llu,%u",
+              (unsigned long long)pconfig->subfiling_stripe_size,
+              pconfig->subfiling_ioc_per_node);
+    else
+      fprintf(fptr, ",-,-");
+    fprintf(fptr, ",%u", prs->reps);
+    for (i = 0; i < NTIMINGS; ++i)
+      fprintf(fptr, ",%.4f,%.4f,%.4f",
+              prs->stddev[i], prs->median[i], prs->ci95[i]);
+
+    /* the load imbalance across ranks */
+    for (i = 0; i < NPHASES; ++i)
+      {
+        double mean = 0.0, sq = 0.0;
+        int r, argmax = 0;
+
+        for (r = 0; r < size; ++r)
+          {
+            mean += pranks[r].t[i];
+            if (pranks[r].t[i] > pranks[argmax].t[i])
+              argmax = r;
+          }
+        mean /= size;
+        for (r = 0; r < size; ++r)
+          sq += (pranks[r].t[i] - mean)*(pranks[r].t[i] - mean);
+
+        fprintf(fptr, ",%.4f,%.4f,%d,%s",
+                mean > 0.0 ? pranks[argmax].t[i]/mean : 1.0,
+                sqrt(sq/size), argmax, pranks[argmax].host);
+      }
+
+    fprintf(fptr, ",%.0f,%.0f,%.4f,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f,%.2f,"
+            "%.1f,%.1f,%.1f,%s,%u,%u,%s,%u,%s,%.0f,%.3f,%.4f,%.4f,%.4f,"
+            "%.4f,%.4f,%s,%u,%.2f,%.4f,%.4f,%llu,%llu,%.0f,%.0f,%.0f,%.0f,"
+            "%s,%s,%s",
+            pts->write_bytes, pts->read_bytes,
+            pts->write_bw_eff, pts->write_bw_raw,
+            pts->read_bw_eff, pts->read_bw_raw,
+            1024.0*pts->write_bw_eff/size, 1024.0*pts->write_bw_raw/size,
+            1024.0*pts->read_bw_eff/size, 1024.0*pts->read_bw_raw/size,
+            pts->create_ops, pts->write_ops, pts->read_ops,
+            pconfig->read_pattern, rgrid.proc_rows, rgrid.proc_cols,
+            generator_name(pconfig),
+            strcmp(generator_name(pconfig), "noisy") == 0 ?
+            pconfig->data_entropy_bits : 0, pconfig->filter,
+            pts->storage_bytes, pts->compression_ratio,
+            pts->filter_time, pts->transfer_time, pts->filter_bw,
+            pts->compressed_bw, pts->uncompressed_bw, pconfig->chunk_write,
+            pconfig->threads_per_rank,
+            1024.0*pts->write_bw_raw/(size*pconfig->threads_per_rank),
+            pts->lock_wait_time, pts->lock_wait_share,
+            (unsigned long long)pconfig->fspace_page_size,
+            (unsigned long long)pconfig->page_buffer_size,
+            pts->page_hits[0], pts->page_misses[0],
+            pts->page_hits[1], pts->page_misses[1],
+            pconfig->mdc_config, pconfig->evict_on_close ? "true" : "false",
+            pconfig->mdc_image ? "true" : "false");
+    for (i = 0; i < 2; ++i)
+      fprintf(fptr, ",%.4f,%.0f,%.0f,%.1f", pts->mdc_hit_rate[i],
+              pts->mdc_max_size[i], pts->mdc_size[i], pts->mdc_entries[i]);
+    fprintf(fptr, ",%u,%llu,%u:%u,%s,%s,%.0f,%.1f,", pconfig->attributes,
+            (unsigned long long)pconfig->attribute_size,
+            pconfig->attr_max_compact, pconfig->attr_min_dense,
+            pconfig->track_times ? "true" : "false",
+            pconfig->no_attrs_hint ? "true" : "false",
+            pts->objects, pts->object_rate);
+    if (pconfig->file_groups == 1)
+      fprintf(fptr, "shared");
+    else if (pconfig->file_groups == 0)
+      fprintf(fptr, "per-rank");
+    else
+      fprintf(fptr, "per-group:%u", pconfig->file_groups);
+    fprintf(fptr, ",%u,%s", file_group_size(pconfig, size),
+            pconfig->mpi_hints);
+    for (i = 0; i < 2; ++i)
+      {
+        char causes[256];
+        mpio_causes_str(pts, i, causes, sizeof(causes));
+        fprintf(fptr, ",%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%.0f,%s",
+                pts->mpio_io_mode[i][H5D_MPIO_NO_COLLECTIVE],
+                pts->mpio_io_mode[i][H5D_MPIO_CHUNK_INDEPENDENT],
+                pts->mpio_io_mode[i][H5D_MPIO_CHUNK_COLLECTIVE],
+                pts->mpio_io_mode[i][H5D_MPIO_CHUNK_MIXED],
+                pts->mpio_io_mode[i][H5D_MPIO_CONTIGUOUS_COLLECTIVE],
+                pts->mpio_chunk_opt[i][H5D_MPIO_LINK_CHUNK],
+                pts->mpio_chunk_opt[i][H5D_MPIO_MULTI_CHUNK], causes);
+      }
+    fprintf(fptr, "\n");
+    fclose(fptr);
+  }
+
+  { /* write the per-rank timings */
+    char rname[PATH_MAX+16];
+    unsigned int i;
+    int r;
+    FILE *fptr;
+
+    rank_file_name(pconfig->csv_file, rname, sizeof(rname));
+    fptr = fopen(rname, "a");
+    assert(fptr != NULL);
+    for (r = 0; r < size; ++r)
+      {
+        fprintf(fptr, "%d,%d,%s,%d,%d", icase, r, pranks[r].host,
+                r / pconfig->proc_cols, r % pconfig->proc_cols);
+        for (i = 0; i < NPHASES; ++i)
+          fprintf(fptr, ",%.4f", pranks[r].t[i]);
+        fprintf(fptr, "\n");
+      }
     fclose(fptr);
   }
 }
@@ -130,16 +590,29 @@ void print_results
 void print_initial_config(const char* ini, configuration* pconfig)
 {
   printf("Config loaded from '%s':\n  steps=%d, arrays=%d, "
-         "rows=%ld, columns=%ld, proc-grid=%dx%d, scaling=%s async=%s\n",
+         "rows=%ld, columns=%ld, proc-grid=%dx%d, scaling=%s async=%s",
          ini, pconfig->steps, pconfig->arrays, pconfig->rows, pconfig->cols,
          pconfig->proc_rows, pconfig->proc_cols, pconfig->scaling, async[pconfig->async] 
          );
+  if (pconfig->async)
+    printf(" async-buffers=%u", pconfig->async_buffers);
+  printf(" data=%s", generator_name(pconfig));
+  if (pconfig->read_proc_rows > 0 && pconfig->read_proc_cols > 0)
+    printf(" read-proc-grid=%dx%d", pconfig->read_proc_rows,
+           pconfig->read_proc_cols);
+  if (pconfig->repetitions > 1 || pconfig->warmup > 0)
+    printf(" repetitions=%u warmup=%u", pconfig->repetitions, pconfig->warmup);
+  if (pconfig->ci_target > 0.0)
+    printf(" ci-target=%.1f%%", pconfig->ci_target);
+  if (strncmp(pconfig->tune, "none", 16) != 0)
+    printf(" tune=%s tune-budget=%u", pconfig->tune, pconfig->tune_budget);
+  printf("\n");
 }
 
 void print_current_config(configuration* pconfig)
 {
   unsigned int size = pconfig->proc_rows*pconfig->proc_cols;
-  char io[16];
+  char io[32];
 
   if (size > 1)
       strncpy(io, (strncmp(pconfig->mpi_io, "collective", 16) == 0) ?
@@ -156,15 +629,43 @@ void print_current_config(configuration* pconfig)
         strncpy(io, "ufo-io", 16);
     }
 
+  strncat(io, io_suffix(pconfig), sizeof(io) - strlen(io) - 1);
+
   printf(HLINE "\n");
-  printf("%s rk=%d %s fill=%s align-[incr:thold]=[%llu:%llu] mblk=%llu fmt=%s io=%s\n",
+  printf("%s rk=%d %s%s%s%s%s%s fill=%s attr=%u%s "
+         "align-[incr:thold]=[%llu:%llu] mblk=%llu "
+         "page-[size:buf]=[%llu:%llu] mdc=%s%s%s "
+         "cc-[nslots:nbytes:w0]=[%llu:%llu:%.2f] fmt=%s io=%s "
+         "files=%u%s%s thr=%u read=%s\n",
          pconfig->slowest_dimension, pconfig->rank,
-         strncmp(pconfig->layout, "contiguous", 16) == 0 ? "cont" : "chkd",
-         pconfig->fill_values,
+         strncmp(pconfig->layout, "contiguous", 16) == 0 ? "cont" :
+         strncmp(pconfig->layout, "compact", 16) == 0 ? "cmpt" :
+         strncmp(pconfig->layout, "virtual", 16) == 0 ? "virt" : "chkd",
+         strncmp(pconfig->layout, "chunked", 16) != 0 ? "" : ":",
+         strncmp(pconfig->layout, "chunked", 16) != 0 ?
+         "" : pconfig->chunk_shape,
+         strncmp(pconfig->layout, "chunked", 16) != 0 ||
+         strcmp(pconfig->filter, "none") == 0 ? "" : "+",
+         strncmp(pconfig->layout, "chunked", 16) != 0 ||
+         strcmp(pconfig->filter, "none") == 0 ? "" : pconfig->filter,
+         strncmp(pconfig->chunk_write, "direct", 16) == 0 ? "(direct)" : "",
+         pconfig->fill_values, pconfig->attributes,
+         pconfig->track_times ? "" : " notimes",
          (unsigned long long)pconfig->alignment_increment,
          (unsigned long long)pconfig->alignment_threshold,
 	 (unsigned long long)pconfig->meta_block_size,
-         pconfig->libver_bound_low, io);
+         (unsigned long long)pconfig->fspace_page_size,
+         (unsigned long long)pconfig->page_buffer_size,
+         pconfig->mdc_config, pconfig->evict_on_close ? "+evict" : "",
+         pconfig->mdc_image ? "+image" : "",
+         (unsigned long long)pconfig->chunk_cache_nslots,
+         (unsigned long long)pconfig->chunk_cache_nbytes,
+         pconfig->chunk_cache_w0,
+         pconfig->libver_bound_low, io, file_groups(pconfig, (int)size),
+         strcmp(pconfig->mpi_hints, "none") == 0 ? "" : " hints=",
+         strcmp(pconfig->mpi_hints, "none") == 0 ? "" : pconfig->mpi_hints,
+         pconfig->threads_per_rank,
+         pconfig->read_pattern);
 }
 
 void get_timings
@@ -174,35 +675,454 @@ void get_timings
  double   write_time,
  double   read_phase,
  double   read_time,
+ const latency* plat,
+ const io_stats* pstats,
+ rank_timing* pranks,
  timings* pts
  )
 {
-  pts->max_write_phase = pts->min_write_phase = 0.0;
-  pts->max_create_time = pts->min_create_time = 0.0;
-  pts->max_write_time = pts->min_write_time = 0.0;
-  pts->max_read_phase = pts->min_read_phase = 0.0;
-  pts->max_read_time = pts->min_read_time = 0.0;
-
-  MPI_Reduce(&write_phase, &pts->min_write_phase, 1, MPI_DOUBLE,
-             MPI_MIN, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&write_phase, &pts->max_write_phase, 1, MPI_DOUBLE,
-             MPI_MAX, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&create_time, &pts->min_create_time, 1, MPI_DOUBLE,
-             MPI_MIN, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&create_time, &pts->max_create_time, 1, MPI_DOUBLE,
-             MPI_MAX, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&write_time, &pts->min_write_time, 1, MPI_DOUBLE,
-             MPI_MIN, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&write_time, &pts->max_write_time, 1, MPI_DOUBLE,
-             MPI_MAX, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&read_phase, &pts->min_read_phase, 1, MPI_DOUBLE,
-             MPI_MIN, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&read_phase, &pts->max_read_phase, 1, MPI_DOUBLE,
-             MPI_MAX, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&read_time, &pts->min_read_time, 1, MPI_DOUBLE,
-             MPI_MIN, 0, MPI_COMM_WORLD);
-  MPI_Reduce(&read_time, &pts->max_read_time, 1, MPI_DOUBLE,
-             MPI_MAX, 0, MPI_COMM_WORLD);
+  io_stats all;
+  latency* pall;
+  int rank, size;
+  unsigned int op, i, j;
+  rank_timing mine;
+  char host[MPI_MAX_PROCESSOR_NAME];
+  int len;
+  double tmin[NPHASES], tmax[NPHASES];
+
+  /* gather the phase timings of all ranks in one go */
+  mine.t[0] = write_phase;
+  mine.t[1] = create_time;
+  mine.t[2] = write_time;
+  mine.t[3] = read_phase;
+  mine.t[4] = read_time;
+  MPI_Get_processor_name(host, &len);
+  strncpy(mine.host, host, HOST_LEN - 1);
+  mine.host[HOST_LEN - 1] = '\0';
+
+  MPI_Gather(&mine, sizeof(rank_timing), MPI_BYTE,
+             pranks, sizeof(rank_timing), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+  /* the min/max of each phase across the ranks */
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &size);
+  for (i = 0; i < NPHASES; ++i)
+    {
+      int r;
+
+      tmin[i] = tmax[i] = (rank == 0) ? pranks[0].t[i] : 0.0;
+      for (r = 1; rank == 0 && r < size; ++r)
+        {
+          if (pranks[r].t[i] < tmin[i])
+            tmin[i] = pranks[r].t[i];
+          if (pranks[r].t[i] > tmax[i])
+            tmax[i] = pranks[r].t[i];
+        }
+    }
+  pts->min_write_phase = tmin[0];  pts->max_write_phase = tmax[0];
+  pts->min_create_time = tmin[1];  pts->max_create_time = tmax[1];
+  pts->min_write_time = tmin[2];   pts->max_write_time = tmax[2];
+  pts->min_read_phase = tmin[3];   pts->max_read_phase = tmax[3];
+  pts->min_read_time = tmin[4];    pts->max_read_time = tmax[4];
+
+  /* merge the per-rank latency histograms and extract the percentiles */
+  pall = (latency*) malloc(sizeof(latency));
+  assert(pall != NULL);
+  latency_reset(pall);
+  latency_reduce(plat, pall, 0, MPI_COMM_WORLD);
+  for (op = 0; op < OP_COUNT; ++op)
+    for (i = 0; i < LAT_NPCT; ++i)
+      pts->op_latency[op][i] = (rank == 0) ?
+        latency_percentile(pall, (h5d_op)op, lat_pct[i]) : 0.0;
+  pts->create_ops = pts->write_ops = pts->read_ops = 0.0;
+  if (rank == 0)
+    {
+      if (pts->max_create_time > 0.0)
+        pts->create_ops = latency_count(pall, OP_CREATE)/pts->max_create_time;
+      if (pts->max_write_time > 0.0)
+        pts->write_ops = latency_count(pall, OP_WRITE)/pts->max_write_time;
+      if (pts->max_read_time > 0.0)
+        pts->read_ops = latency_count(pall, OP_READ)/pts->max_read_time;
+    }
+  free(pall);
+
+  /* the modeled chunk cache hit rates */
+  MPI_Reduce((void*)pstats, &all, sizeof(io_stats)/sizeof(unsigned long long),
+             MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+  pts->write_chunk_hit_rate = pts->read_chunk_hit_rate = 0.0;
+  pts->compute_time = pts->async_wait_time = pts->io_overlap = 0.0;
+  pts->write_bytes = pts->read_bytes = 0.0;
+  pts->write_bw_eff = pts->write_bw_raw = 0.0;
+  pts->read_bw_eff = pts->read_bw_raw = 0.0;
+  pts->storage_bytes = pts->compression_ratio = 0.0;
+  pts->objects = pts->object_rate = 0.0;
+  pts->filter_time = pts->transfer_time = pts->filter_bw = 0.0;
+  pts->compressed_bw = pts->uncompressed_bw = 0.0;
+  pts->lock_wait_time = pts->lock_wait_share = 0.0;
+  memset(pts->mpio_io_mode, 0, sizeof(pts->mpio_io_mode));
+  memset(pts->mpio_chunk_opt, 0, sizeof(pts->mpio_chunk_opt));
+  memset(pts->mpio_cause, 0, sizeof(pts->mpio_cause));
+  for (i = 0; i < 2; ++i)
+    {
+      pts->page_hits[i] = pts->page_misses[i] = 0.0;
+      pts->mdc_hit_rate[i] = pts->mdc_max_size[i] = 0.0;
+      pts->mdc_size[i] = pts->mdc_entries[i] = 0.0;
+    }
+  if (rank == 0)
+    {
+      if (all.write_chunk_hits + all.write_chunk_misses > 0)
+        pts->write_chunk_hit_rate = (double)all.write_chunk_hits/
+          (double)(all.write_chunk_hits + all.write_chunk_misses);
+      if (all.read_chunk_hits + all.read_chunk_misses > 0)
+        pts->read_chunk_hit_rate = (double)all.read_chunk_hits/
+          (double)(all.read_chunk_hits + all.read_chunk_misses);
+
+      /* The writes of a buffer were in flight during the compute phases
+         until we had to wait for them, so compute/(compute + wait) is the
+         fraction of the write I/O that was hidden. */
+      pts->compute_time = 1.0e-9*(double)all.compute_ns/size;
+      pts->async_wait_time = 1.0e-9*(double)all.async_wait_ns/size;
+      if (all.compute_ns + all.async_wait_ns > 0)
+        pts->io_overlap = (double)all.compute_ns/
+          (double)(all.compute_ns + all.async_wait_ns);
+
+      /* the slowest rank determines the aggregate throughput */
+      pts->write_bytes = (double)all.write_bytes;
+      pts->read_bytes = (double)all.read_bytes;
+      if (pts->max_write_phase > 0.0)
+        pts->write_bw_eff = pts->write_bytes/GIB/pts->max_write_phase;
+      if (pts->max_write_time > 0.0)
+        pts->write_bw_raw = pts->write_bytes/GIB/pts->max_write_time;
+      if (pts->max_read_phase > 0.0)
+        pts->read_bw_eff = pts->read_bytes/GIB/pts->max_read_phase;
+      if (pts->max_read_time > 0.0)
+        pts->read_bw_raw = pts->read_bytes/GIB/pts->max_read_time;
+
+      /* The filters run as part of the writes or, for the chunks left in
+         the cache, the closes, so we split the slowest rank's write phase
+         into the mean filter time and the rest. */
+      pts->storage_bytes = (double)all.storage_bytes;
+      pts->objects = (double)all.objects;
+      if (pts->max_create_time > 0.0)
+        pts->object_rate = pts->objects/pts->max_create_time;
+      if (all.storage_bytes > 0)
+        pts->compression_ratio = (double)all.dataset_bytes/
+          (double)all.storage_bytes;
+      pts->filter_time = 1.0e-9*(double)all.filter_ns/size;
+      if (pts->max_write_phase > pts->filter_time)
+        pts->transfer_time = pts->max_write_phase - pts->filter_time;
+      if (pts->filter_time > 0.0)
+        pts->filter_bw = (double)all.dataset_bytes/GIB/pts->filter_time;
+      if (pts->max_write_phase > 0.0)
+        {
+          pts->compressed_bw = pts->storage_bytes/GIB/pts->max_write_phase;
+          pts->uncompressed_bw =
+            (double)all.dataset_bytes/GIB/pts->max_write_phase;
+        }
+
+      /* the waits overlap with the other threads' writes */
+      pts->lock_wait_time = 1.0e-9*(double)all.lock_wait_ns/size;
+      if (all.thread_call_ns > 0)
+        pts->lock_wait_share = (double)all.lock_wait_ns/
+          (double)all.thread_call_ns;
+
+      for (i = 0; i < 2; ++i)
+        {
+          pts->page_hits[i] = (double)all.page_hits[i];
+          pts->page_misses[i] = (double)all.page_misses[i];
+          pts->mdc_hit_rate[i] = 1.0e-6*(double)all.mdc_hit_ppm[i]/size;
+          pts->mdc_max_size[i] = (double)all.mdc_max_size[i]/size;
+          pts->mdc_size[i] = (double)all.mdc_size[i]/size;
+          pts->mdc_entries[i] = (double)all.mdc_entries[i]/size;
+          for (j = 0; j < MPIO_IO_MODES; ++j)
+            pts->mpio_io_mode[i][j] = (double)all.mpio_io_mode[i][j];
+          for (j = 0; j < MPIO_CHUNK_OPT; ++j)
+            pts->mpio_chunk_opt[i][j] = (double)all.mpio_chunk_opt[i][j];
+          for (j = 0; j < MPIO_CAUSES; ++j)
+            pts->mpio_cause[i][j] = (double)all.mpio_cause[i][j];
+        }
+    }
+}
+
+/*
+ *
+ * Statistics across the repetitions of a case
+ *
+ */
+
+void timing_values(double wall_time, const timings* pts, double v[])
+{
+  v[0] = wall_time;
+  v[1] = pts->min_write_phase;  v[2] = pts->max_write_phase;
+  v[3] = pts->min_create_time;  v[4] = pts->max_create_time;
+  v[5] = pts->min_write_time;   v[6] = pts->max_write_time;
+  v[7] = pts->min_read_phase;   v[8] = pts->max_read_phase;
+  v[9] = pts->min_read_time;    v[10] = pts->max_read_time;
+}
+
+/* psum += weight*pts, field by field (timings holds only doubles) */
+
+void timings_add(timings* psum, const timings* pts, double weight)
+{
+  double* s = (double*) psum;
+  const double* t = (const double*) pts;
+  size_t i;
+
+  for (i = 0; i < sizeof(timings)/sizeof(double); ++i)
+    s[i] += weight*t[i];
+}
+
+/* the same for the phase timings of size ranks (keeps the host names) */
+
+void rank_timings_add(rank_timing* psum, const rank_timing* pranks, int size,
+                      double weight)
+{
+  int r;
+  unsigned int i;
+
+  for (r = 0; r < size; ++r)
+    {
+      for (i = 0; i < NPHASES; ++i)
+        psum[r].t[i] += weight*pranks[r].t[i];
+      if (psum != pranks)
+        memcpy(psum[r].host, pranks[r].host, HOST_LEN);
+    }
+}
+
+/* two-sided 95% quantiles of Student's t for 1..30 degrees of freedom */
+
+static const double t95[30] = {
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+  2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+  2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static int compare_double(const void* a, const void* b)
+{
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/* samples holds reps rows of NTIMINGS values */
+
+void get_rep_stats(const double* samples, unsigned int reps, rep_stats* prs)
+{
+  unsigned int i, r;
+  double* col;
+
+  assert(reps > 0);
+  col = (double*) malloc(reps*sizeof(double));
+  assert(col != NULL);
+
+  memset(prs, 0, sizeof(rep_stats));
+  prs->reps = reps;
+
+  for (i = 0; i < NTIMINGS; ++i)
+    {
+      double sum = 0.0, sq = 0.0;
+
+      for (r = 0; r < reps; ++r)
+        {
+          col[r] = samples[r*NTIMINGS + i];
+          sum += col[r];
+        }
+      prs->mean[i] = sum/reps;
+
+      qsort(col, reps, sizeof(double), compare_double);
+      prs->median[i] = (reps%2 == 1) ? col[reps/2] :
+        0.5*(col[reps/2 - 1] + col[reps/2]);
+
+      if (reps > 1)
+        {
+          for (r = 0; r < reps; ++r)
+            sq += (col[r] - prs->mean[i])*(col[r] - prs->mean[i]);
+          prs->stddev[i] = sqrt(sq/(reps - 1));
+          prs->ci95[i] = (reps - 1 <= 30 ? t95[reps - 2] : 1.96)*
+            prs->stddev[i]/sqrt((double)reps);
+        }
+    }
+
+  free(col);
+}
+
+/*
+ *
+ * Use the subfiling VFD (with the IOC VFD) instead of the MPI-IO VFD. Zero
+ * stripe size or IOCs per node keep the library defaults.
+ *
+ */
+
+herr_t set_fapl_subfiling(const configuration* pconfig, hid_t fapl)
+{
+  herr_t result = -1;
+#if H5_VERSION_GE(1,14,0) && defined(H5_HAVE_SUBFILING_VFD)
+  H5FD_subfiling_config_t cfg;
+  char ioc_per_node[16];
+
+  /* the defaults, since fapl doesn't use the subfiling VFD yet */
+  if ((result = H5Pget_fapl_subfiling(fapl, &cfg)) < 0)
+    return result;
+
+  cfg.shared_cfg.ioc_selection = SELECT_IOC_ONE_PER_NODE;
+  if (pconfig->subfiling_stripe_size > 0)
+    cfg.shared_cfg.stripe_size = (int64_t)pconfig->subfiling_stripe_size;
+
+  /* the IOC count per node is only configurable via the environment */
+  if (pconfig->subfiling_ioc_per_node > 0)
+    {
+      snprintf(ioc_per_node, sizeof(ioc_per_node), "%u",
+               pconfig->subfiling_ioc_per_node);
+      setenv(H5FD_SUBFILING_IOC_PER_NODE, ioc_per_node, 1);
+    }
+
+  result = H5Pset_fapl_subfiling(fapl, &cfg);
+#else
+  printf("ERROR: subfiling requires HDF5 version >= 1.14 built with the "
+         "subfiling VFD\n");
+  MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+  return result;
+}
+
+/*
+ *
+ * Add the page buffer hits and misses (metadata and raw data) of an open
+ * file to the stats
+ *
+ */
+
+void get_page_buffer_stats(const configuration* pconfig, hid_t file,
+                           io_stats* pstats)
+{
+  unsigned int accesses[2], hits[2], misses[2], evictions[2], bypasses[2];
+  unsigned int i;
+
+  if (pconfig->page_buffer_size == 0)
+    return;
+
+  assert(H5Fget_page_buffering_stats(file, accesses, hits, misses, evictions,
+                                     bypasses) >= 0);
+  for (i = 0; i < 2; ++i)
+    {
+      pstats->page_hits[i]   += hits[i];
+      pstats->page_misses[i] += misses[i];
+    }
+}
+
+/*
+ *
+ * Configure the metadata cache: its size, evict on close, and whether to
+ * write a cache image when the file is closed
+ *
+ */
+
+herr_t set_mdc_config(const configuration* pconfig, hid_t fapl)
+{
+  herr_t result = 0;
+  H5AC_cache_config_t cfg;
+  H5AC_cache_image_config_t icfg;
+  hid_t tmp;
+  size_t init, min, max;
+  double flash;
+
+  /* start from the library's defaults, not the last case's */
+  assert((tmp = H5Pcreate(H5P_FILE_ACCESS)) >= 0);
+  cfg.version = H5AC__CURR_CACHE_CONFIG_VERSION;
+  assert(H5Pget_mdc_config(tmp, &cfg) >= 0);
+  assert(H5Pclose(tmp) >= 0);
+
+  if (strcmp(pconfig->mdc_config, "default") != 0)
+    {
+      assert(parse_mdc_config(pconfig->mdc_config, &init, &min, &max,
+                              &flash) == 0);
+      cfg.set_initial_size = 1;
+      cfg.initial_size = init;
+      cfg.min_size = min;
+      cfg.max_size = max;
+      if (flash > 0.0)
+        {
+          cfg.flash_incr_mode = H5C_flash_incr__add_space;
+          cfg.flash_multiple = flash;
+        }
+      else
+        cfg.flash_incr_mode = H5C_flash_incr__off;
+    }
+  if ((result = H5Pset_mdc_config(fapl, &cfg)) < 0)
+    return result;
+
+#ifndef H5_HAVE_PARALLEL
+  if ((result = H5Pset_evict_on_close(fapl, pconfig->evict_on_close)) < 0)
+    return result;
+#endif
+
+  icfg.version = H5AC__CURR_CACHE_IMAGE_CONFIG_VERSION;
+  icfg.generate_image = pconfig->mdc_image;
+  icfg.save_resize_status = 0;
+  icfg.entry_ageout = H5AC__CACHE_IMAGE__ENTRY_AGEOUT__NONE;
+  result = H5Pset_mdc_image_config(fapl, &icfg);
+
+  return result;
+}
+
+/*
+ *
+ * Add the metadata cache hit rate, size, and number of entries of an open
+ * file to the stats of a phase (0 = write, 1 = read)
+ *
+ */
+
+void get_mdc_stats(hid_t file, unsigned int phase, io_stats* pstats)
+{
+  double hit_rate;
+  size_t max_size, min_clean_size, cur_size;
+  int cur_num_entries;
+
+  assert(H5Fget_mdc_hit_rate(file, &hit_rate) >= 0);
+  assert(H5Fget_mdc_size(file, &max_size, &min_clean_size, &cur_size,
+                         &cur_num_entries) >= 0);
+  pstats->mdc_hit_ppm[phase]  += (unsigned long long)(hit_rate*1.0e6 + 0.5);
+  pstats->mdc_max_size[phase] += (unsigned long long)max_size;
+  pstats->mdc_size[phase]     += (unsigned long long)cur_size;
+  pstats->mdc_entries[phase]  += (unsigned long long)cur_num_entries;
+}
+
+/*
+ *
+ * Add the outcome of the last collective transfer with dxpl to the stats of a
+ * phase (0 = write, 1 = read). The library may quietly fall back to
+ * independent I/O, e.g., for type conversions or filters.
+ *
+ */
+
+void get_mpio_stats(hid_t dxpl, unsigned int phase, io_stats* pstats)
+{
+#ifdef H5_HAVE_PARALLEL
+  H5FD_mpio_xfer_t xfer_mode;
+  H5D_mpio_actual_io_mode_t io_mode;
+  H5D_mpio_actual_chunk_opt_mode_t chunk_opt;
+  uint32_t local_cause, global_cause;
+  unsigned int i;
+
+  assert(H5Pget_dxpl_mpio(dxpl, &xfer_mode) >= 0);
+  if (xfer_mode != H5FD_MPIO_COLLECTIVE)
+    return;
+
+  assert(H5Pget_mpio_actual_io_mode(dxpl, &io_mode) >= 0);
+  assert(H5Pget_mpio_actual_chunk_opt_mode(dxpl, &chunk_opt) >= 0);
+  assert(H5Pget_mpio_no_collective_cause(dxpl, &local_cause,
+                                         &global_cause) >= 0);
+  if ((unsigned int)io_mode < MPIO_IO_MODES)
+    ++pstats->mpio_io_mode[phase][io_mode];
+  if ((unsigned int)chunk_opt < MPIO_CHUNK_OPT)
+    ++pstats->mpio_chunk_opt[phase][chunk_opt];
+  for (i = 0; i < MPIO_CAUSES; ++i)
+    if (local_cause & (1u << i))
+      ++pstats->mpio_cause[phase][i];
+#else
+  (void) dxpl;
+  (void) phase;
+  (void) pstats;
+#endif
 }
 
 herr_t set_libver_bounds(configuration* pconfig, int rank, hid_t fapl)
@@ -281,92 +1201,49 @@ herr_t set_libver_bounds(configuration* pconfig, int rank, hid_t fapl)
   return result;
 }
 
+/* Keep the header and the lines of cases 1..ncases in a side file whose
+   lines start with the case number (a missing file is fine) */
+
+static void drop_cases(const char* name, unsigned int ncases)
+{
+  char* rcommand;
+  size_t len;
+  FILE* fptr;
+
+  if ((fptr = fopen(name, "r")) == NULL)
+    return;
+  fclose(fptr);
+  /* the command has the file name four times (and a case number) */
+  len = 4*strlen(name) + 64;
+  assert((rcommand = (char*) malloc(len)) != NULL);
+  snprintf(rcommand, len,
+           "awk -F, 'NR == 1 || $1 <= %u' %s > %s.tmp && mv %s.tmp %s",
+           ncases, name, name, name, name);
+  system(rcommand);
+  free(rcommand);
+}
+
 /*
  *
- * Restart from last fully completed configuration
+ * Restart from last fully completed configuration. The CSV file has a line
+ * per completed case, and the cases are enumerated in the same order for the
+ * same configuration, so we can resume from (and including) the last one.
+ * Returns the number of cases to skip.
  *
  */
 
-void restart(
-             restart_t *ckpt, 
-             const char* fname,
-             char* slow_dim[],
-             char* fill[],
-             char* layout[],
-             char* fmt_low[],
-             char* mpi_mod[],
-             hsize_t mblk_size[],
-             hsize_t align_incr[]
-)
+unsigned int restart(const char* fname)
 {
   FILE *fptr;                         /* File pointer */
-  static const long max_len = 200+ 1; /* define the max length of the line to read */
-  char buf[max_len + 1];              /* define the buffer and allocate the length */
+  unsigned int lines = 0;
+  int c;
 
   if ((fptr = fopen(fname, "rb")) != NULL)
     {
-      fseek(fptr, -max_len, SEEK_END); /* set pointer to the end of file minus a length. There can be more than one new line character */
-      fread(buf, max_len-1, 1, fptr);  /* read the contents of the file from the fseek() position */
+      while ((c = fgetc(fptr)) != EOF)
+        if (c == '\n')
+          ++lines;
       fclose(fptr);                    /* close the file */
-      
-      buf[max_len-1] = '\0';           /* reset the string */
-      char *last_newline = strrchr(buf, '\n'); /* find last occurrence of newline */
-      char *last_line = last_newline+1;        /* jump to it */
-      
-      printf("RESTARTING FROM LAST LINE: [%s]\n", last_line);
-
-      if( strstr(last_line, slow_dim[1]) != NULL) {
-        ckpt->islow = 1;
-      } else {
-        ckpt->islow = 0;
-      } 
-      if( strstr(last_line, layout[1]) != NULL) {
-        ckpt->ilay = 1;
-      } else {
-        ckpt->ilay = 0;
-      } 
-      if( strstr(last_line, fill[1]) != NULL) {
-        ckpt->ifill = 1;
-      } else {
-        ckpt->ifill = 0;
-      } 
-      if( strstr(last_line, fmt_low[1]) != NULL) {
-        ckpt->ifmt = 1;
-      } else {
-        ckpt->ifmt = 0;
-      } 
-      if( strstr(last_line, mpi_mod[1]) != NULL) {
-        ckpt->imod = 1;
-      } else {
-        ckpt->imod = 0;
-      }
-
-      char delim[] = ",";
-      char *ptr = strtok(last_line,delim);
-      
-      int icnt = 0;
-      while(ptr != NULL)
-        {
-          if(icnt == 8) {
-            ckpt->irank = atoi(ptr);
-          } else if(icnt == 10) {
-            if( (hsize_t)atoi(ptr) != align_incr[0]) {
-              ckpt->ialig = 1;
-            } else {
-              ckpt->ialig = 0;
-            }
-          } else if(icnt == 12) {
-            if( (hsize_t)atoi(ptr) == mblk_size[0] ) {
-              ckpt->imblk = 0;
-            } else {
-              ckpt->imblk = 1;
-            }
-          } else if(icnt == 17) {
-            ckpt->async = (unsigned int)atoi(ptr);
-          }
-          icnt++;
-          ptr = strtok(NULL, delim);
-        }
     }
   else {
     /* Could not open restart file */
@@ -374,6 +1251,12 @@ void restart(
     MPI_Abort(MPI_COMM_WORLD, 1);
   }
 
+  /* the header doesn't count */
+  if (lines <= 1)
+    return 0;
+
+  printf("RESTARTING FROM CASE %u\n", lines - 1);
+
   /* Repeating the last successful configuration,
      so remove the last line to avoid duplicate lines */
   int len = strlen(fname);
@@ -381,5 +1264,14 @@ void restart(
   strcpy(command, "sed -i '$d' ");
   strcat(command, fname);
   system(command);
-  
+
+  { /* drop the per-rank timings and the hints of the repeated case */
+    char rname[PATH_MAX+16];
+    rank_file_name(fname, rname, sizeof(rname));
+    drop_cases(rname, lines - 2);
+    hints_file_name(fname, rname, sizeof(rname));
+    drop_cases(rname, lines - 2);
+  }
+
+  return lines - 2;
 }
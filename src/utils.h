@@ -15,9 +15,21 @@
 #define UTILS_H
 
 #include "configuration.h"
+#include "latency.h"
 
 #include "hdf5.h"
 
+/*
+ * The outcomes of the collective transfers, as reported by the library: the
+ * actual I/O mode (H5D_mpio_actual_io_mode_t, 0 through 4), the chunk
+ * optimization (H5D_mpio_actual_chunk_opt_mode_t, 0 through 2), and the bits
+ * of the reasons why a transfer wasn't collective
+ */
+
+#define MPIO_IO_MODES  5
+#define MPIO_CHUNK_OPT 3
+#define MPIO_CAUSES    16
+
 typedef struct
 {
   double min_write_phase;
@@ -30,23 +42,136 @@ typedef struct
   double max_read_phase;
   double min_read_time;
   double max_read_time;
+  /* per-operation latency percentiles (see lat_pct) across all ranks */
+  double op_latency[OP_COUNT][LAT_NPCT];
+  /* modeled chunk cache hit rates across all ranks */
+  double write_chunk_hit_rate;
+  double read_chunk_hit_rate;
+  /* mean emulated compute and async buffer wait time per rank */
+  double compute_time;
+  double async_wait_time;
+  double io_overlap;
+  /* bytes moved across all ranks, and the aggregate throughput based on the
+     slowest rank's phase (effective) and H5D call (raw) times */
+  double write_bytes;
+  double read_bytes;
+  double write_bw_eff;   /* [GiB/s] */
+  double write_bw_raw;
+  double read_bw_eff;
+  double read_bw_raw;
+  double create_ops;     /* [1/s] */
+  double write_ops;
+  double read_ops;
+  /* the datasets' storage vs. logical size and the write phase split into
+     the (estimated) filter time and the rest */
+  double storage_bytes;
+  double compression_ratio;
+  double filter_time;
+  double transfer_time;
+  double filter_bw;       /* [GiB/s] of uncompressed data */
+  double compressed_bw;   /* storage bytes over the write phase */
+  double uncompressed_bw; /* logical bytes over the write phase */
+  /* the write threads' mean time per rank waiting for the library lock,
+     and its share of their time in H5Dwrite */
+  double lock_wait_time;
+  double lock_wait_share;
+  /* page buffer hits and misses across all ranks (metadata, raw data) */
+  double page_hits[2];
+  double page_misses[2];
+  /* the metadata cache at the end of the write and read phase (the means
+     across ranks) */
+  double mdc_hit_rate[2];
+  double mdc_max_size[2];
+  double mdc_size[2];
+  double mdc_entries[2];
+  /* the groups, datasets, and attributes created in the file, and their rate
+     based on the slowest rank's create time */
+  double objects;
+  double object_rate;   /* [1/s] */
+  /* the collective transfers of the write and read phase by outcome, summed
+     across ranks (see io_stats) */
+  double mpio_io_mode[2][MPIO_IO_MODES];
+  double mpio_chunk_opt[2][MPIO_CHUNK_OPT];
+  double mpio_cause[2][MPIO_CAUSES];
 } timings;
 
+/*
+ * The wall clock time and the min/max columns of timings (in this order)
+ * across the repetitions of a case
+ */
+
+#define NTIMINGS 11
+
+/* at least this many repetitions before we check the confidence interval */
+#define MIN_CI_REPS 3
+
+typedef struct
+{
+  unsigned int reps;
+  double mean[NTIMINGS];
+  double stddev[NTIMINGS];
+  double median[NTIMINGS];
+  double ci95[NTIMINGS];   /* half-width of the 95% confidence interval */
+} rep_stats;
+
+/*
+ * The phase timings of one rank: write phase, create, write, read phase, and
+ * read time (in this order)
+ */
+
+#define NPHASES 5
+#define HOST_LEN 64
+
+typedef struct
+{
+  double t[NPHASES];
+  char host[HOST_LEN];
+} rank_timing;
+
+/* Per-rank counters collected during a case */
+
 typedef struct
 {
-  unsigned int irank;
-  unsigned int islow;
-  unsigned int ifill;
-  unsigned int ilay;
-  unsigned int ialig;
-  unsigned int imblk;
-  unsigned int ifmt;
-  unsigned int imod;
-  unsigned int async;
-} restart_t;
+  unsigned long long write_chunk_hits;
+  unsigned long long write_chunk_misses;
+  unsigned long long read_chunk_hits;
+  unsigned long long read_chunk_misses;
+  unsigned long long compute_ns;    /* emulated compute phase */
+  unsigned long long async_wait_ns; /* blocked on in-flight async writes */
+  unsigned long long write_bytes;   /* selected by H5Dwrite calls */
+  unsigned long long read_bytes;    /* selected by H5Dread calls */
+  unsigned long long storage_bytes; /* of the datasets (rank 0 only) */
+  unsigned long long dataset_bytes; /* their logical size (rank 0 only) */
+  unsigned long long filter_ns;     /* estimated filter pipeline time */
+  unsigned long long thread_call_ns; /* the write threads' H5Dwrite calls */
+  unsigned long long lock_wait_ns;  /* the part spent waiting for the lock */
+  unsigned long long page_hits[2];  /* page buffer, metadata and raw data */
+  unsigned long long page_misses[2];
+  /* the metadata cache at the end of the write and read phase */
+  unsigned long long mdc_hit_ppm[2];  /* hit rate [1e-6] */
+  unsigned long long mdc_max_size[2];
+  unsigned long long mdc_size[2];
+  unsigned long long mdc_entries[2];
+  unsigned long long objects;       /* created in the file (rank 0 only) */
+  /* the collective transfers of the write and read phase by outcome */
+  unsigned long long mpio_io_mode[2][MPIO_IO_MODES];
+  unsigned long long mpio_chunk_opt[2][MPIO_CHUNK_OPT];
+  unsigned long long mpio_cause[2][MPIO_CAUSES];
+} io_stats;
 
 void create_output_file(const char* fname);
 
+void rank_file_name(const char* fname, char* rname, size_t len);
+
+void hints_file_name(const char* fname, char* hname, size_t len);
+
+void tuned_file_name(const char* fname, char* tname, size_t len);
+
+void create_mpi_info(const configuration* pconfig, MPI_Info* info);
+
+void log_mpi_hints(const char* csv_file, int icase, MPI_Comm comm,
+                   const char* hdf5_filename, MPI_Info info);
+
 void print_initial_config(const char* ini, configuration* pconfig);
 
 void print_current_config(configuration* pconfig);
@@ -58,6 +183,9 @@ void get_timings
  double   write_time,
  double   read_phase,
  double   read_time,
+ const latency* plat,
+ const io_stats* pstats,
+ rank_timing* pranks,
  timings* pts
  );
 
@@ -65,23 +193,36 @@ void print_results
 (
  configuration* pconfig, 
  char*          hdf5_filename,
- double         wall_time,
- timings*       pts
+ const rep_stats* prs,
+ timings*       pts,
+ const rank_timing* pranks,
+ int            size,
+ int            icase
  );
 
+void timing_values(double wall_time, const timings* pts, double v[]);
+
+void timings_add(timings* psum, const timings* pts, double weight);
+
+void rank_timings_add(rank_timing* psum, const rank_timing* pranks, int size,
+                      double weight);
+
+void get_rep_stats(const double* samples, unsigned int reps, rep_stats* prs);
+
+void get_page_buffer_stats(const configuration* pconfig, hid_t file,
+                           io_stats* pstats);
+
+herr_t set_mdc_config(const configuration* pconfig, hid_t fapl);
+
+void get_mdc_stats(hid_t file, unsigned int phase, io_stats* pstats);
+
+void get_mpio_stats(hid_t dxpl, unsigned int phase, io_stats* pstats);
+
 herr_t set_libver_bounds(configuration* config, int rank, hid_t fapl);
 
-void restart(
-             restart_t *ckpt, 
-             const char* fname,
-             char* slow_dim[],
-             char* fill[],
-             char* layout[],
-             char* fmt_low[],
-             char* mpi_mod[],
-             hsize_t mblk_size[],
-             hsize_t align_incr[]
-);
+herr_t set_fapl_subfiling(const configuration* config, hid_t fapl);
+
+unsigned int restart(const char* fname);
 
 
 int parse_time(char *str_in, duration *time);
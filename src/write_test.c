@@ -14,6 +14,7 @@
 #include "write_test.h"
 
 #include "dataset.h"
+#include "pipeline.h"
 
 #include <assert.h>
 #include <stdio.h>
@@ -21,6 +22,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 void
 sleep_(duration sleep_time)
 {
@@ -53,6 +58,343 @@ async_sleep(hid_t file_id, hid_t fapl, duration sleep_time)
     sleep_(sleep_time);
 }
 
+/*
+ *
+ * Write the selections of several datasets in a single call
+ *
+ */
+
+static void write_multi(size_t count, hid_t dset[], hid_t mtype[],
+                        hid_t mspace[], hid_t fspace[], hid_t dxpl,
+                        const void* buf[], time_step* es)
+{
+#if H5_VERSION_GE(1,14,0)
+  if(es != NULL)
+    assert(H5Dwrite_multi_async(count, dset, mtype, mspace, fspace, dxpl, buf,
+                                es->es_data) >= 0);
+  else
+    assert(H5Dwrite_multi(count, dset, mtype, mspace, fspace, dxpl, buf) >= 0);
+#else
+  printf("ERROR: multi-dataset I/O requires HDF5 version >= 1.14\n");
+  MPI_Abort(MPI_COMM_WORLD, 1);
+#endif
+}
+
+/*
+ *
+ * The number of datasets along the steps and the arrays, and their names (as
+ * created by write_test)
+ *
+ */
+
+static void dataset_counts(const configuration* pconfig, unsigned int* nsteps,
+                           unsigned int* narrays)
+{
+  unsigned int step_first_flg =
+    (strncmp(pconfig->slowest_dimension, "step", 16) == 0);
+
+  *nsteps = *narrays = 1;
+  if (pconfig->rank == 2)
+    {
+      *nsteps = pconfig->steps;
+      *narrays = pconfig->arrays;
+    }
+  else if (pconfig->rank == 3)
+    {
+      if (step_first_flg)
+        *nsteps = pconfig->steps;
+      else
+        *narrays = pconfig->arrays;
+    }
+}
+
+static void dataset_path(const configuration* pconfig, unsigned int istep,
+                         unsigned int iarray, char* path)
+{
+  unsigned int step_first_flg =
+    (strncmp(pconfig->slowest_dimension, "step", 16) == 0);
+
+  switch (pconfig->rank)
+    {
+    case 2:
+      sprintf(path, (step_first_flg ? "step=%d/array=%d" : "array=%d/step=%d"),
+              (step_first_flg ? istep : iarray),
+              (step_first_flg ? iarray : istep));
+      break;
+    case 3:
+      if (step_first_flg)
+        sprintf(path, "step=%d", istep);
+      else
+        sprintf(path, "array=%d", iarray);
+      break;
+    default:
+      sprintf(path, "dataset");
+      break;
+    }
+}
+
+/*
+ *
+ * Write a rank's block (selected in fspace) as whole chunks, which the rank
+ * encodes itself on all threads before it hands them to H5Dwrite_chunk one
+ * by one. writes_whole_chunks() (cases.c) made sure that the block is a union
+ * of chunks, and case_possible() that the rank has the file to itself.
+ *
+ */
+
+static void write_chunks(const configuration* pconfig, hid_t dset,
+                         hid_t fspace, hid_t dxpl, const double* buf,
+                         unsigned long my_rows, unsigned long my_cols,
+                         io_stats* pstats)
+{
+  filter_spec filters[MAX_PIPELINE];
+  unsigned int count, lead, i;
+  hsize_t cdims[H5S_MAX_RANK], start[H5S_MAX_RANK], end[H5S_MAX_RANK];
+  hsize_t offset[H5S_MAX_RANK];
+  size_t crows, ccols, ncols, nchunks, cap, *sizes;
+  unsigned char* chunks;
+  long c;
+  double t;
+
+  assert(pipeline_parse(pconfig->filter, filters, &count) == 0);
+  chunk_dims(pconfig, cdims);
+  lead = pconfig->rank - 2;
+  crows = (size_t)cdims[lead];
+  ccols = (size_t)cdims[lead + 1];
+  ncols = my_cols/ccols;
+  nchunks = (my_rows/crows)*ncols;
+  assert(H5Sget_select_bounds(fspace, start, end) >= 0);
+
+  /* room for the largest encoding, rounded up to whole doubles */
+  cap = pipeline_bound(filters, count, crows*ccols*sizeof(double));
+  cap = (cap + sizeof(double) - 1)/sizeof(double)*sizeof(double);
+  assert((chunks = (unsigned char*) malloc(nchunks*cap)) != NULL);
+  assert((sizes = (size_t*) malloc(nchunks*sizeof(size_t))) != NULL);
+
+  t = -MPI_Wtime();
+#pragma omp parallel
+  {
+    unsigned char* work = (unsigned char*) malloc(cap);
+    double* chunk;
+    size_t r, q, j;
+
+    assert(work != NULL);
+#pragma omp for schedule(dynamic)
+    for (c = 0; c < (long)nchunks; ++c)
+      {
+        r = (size_t)c/ncols;
+        q = (size_t)c%ncols;
+        chunk = (double*)(chunks + (size_t)c*cap);
+        for (j = 0; j < crows; ++j)
+          memcpy(chunk + j*ccols, buf + (r*crows + j)*my_cols + q*ccols,
+                 ccols*sizeof(double));
+        sizes[c] = pipeline_encode(filters, count, sizeof(double),
+                                   (unsigned char*)chunk,
+                                   crows*ccols*sizeof(double), work, cap);
+      }
+    free(work);
+  }
+  t += MPI_Wtime();
+  pstats->filter_ns += (unsigned long long)(t*1.0e9);
+
+  for (i = 0; i < lead; ++i)
+    offset[i] = start[i];
+  for (c = 0; c < (long)nchunks; ++c)
+    {
+      offset[lead] = start[lead] + (hsize_t)((size_t)c/ncols*crows);
+      offset[lead + 1] = start[lead + 1] + (hsize_t)((size_t)c%ncols*ccols);
+      assert(H5Dwrite_chunk(dset, dxpl, 0, offset, sizes[c],
+                            chunks + (size_t)c*cap) >= 0);
+    }
+
+  free(sizes);
+  free(chunks);
+}
+
+/*
+ *
+ * Write the arrays of a step (one dataset each) on pconfig->threads_per_rank
+ * threads, each from its own buffer in wbufs. The datasets are created or
+ * opened and closed by this thread, since in parallel that's collective,
+ * and only the H5Dwrite calls run concurrently. Unless the library is
+ * thread-safe, we serialize them ourselves. Either way, only one thread is
+ * inside the library at a time, so the threads' call times beyond the
+ * duration of the parallel region were spent waiting for the lock.
+ *
+ */
+
+static void write_arrays_threaded
+(
+ configuration* pconfig,
+ hid_t file,
+ unsigned int istep,
+ const proc_grid* grid,
+ int my_proc_row,
+ int my_proc_col,
+ unsigned long my_rows,
+ unsigned long my_cols,
+ double* wbufs,
+ hid_t mspace,
+ hid_t lcpl,
+ hid_t dapl,
+ hid_t dxpl,
+ unsigned int coll_mpi_io_flg,
+ double* create_time,
+ double* write_time,
+ latency* plat,
+ cc_model* pccm,
+ io_stats* pstats
+ )
+{
+  unsigned int step_first_flg, iarray;
+  hid_t *dset, *fspace;
+  double *op_times, op_time, calls = 0.0;
+  char path[255];
+  long i;
+
+  step_first_flg = (strncmp(pconfig->slowest_dimension, "step", 16) == 0);
+  dset     = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+  fspace   = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+  op_times = (double*) malloc(pconfig->arrays*sizeof(double));
+
+  for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+    {
+      /* rank 2: group per step or array of 2D datasets,
+         rank 3: a dataset per array, which grows by a step at a time */
+      if (pconfig->rank == 2)
+        sprintf(path, (step_first_flg ? "step=%d/array=%d" : "array=%d/step=%d"),
+                (step_first_flg ? istep : iarray),
+                (step_first_flg ? iarray : istep));
+      else
+        sprintf(path, "array=%d", iarray);
+      op_time = -MPI_Wtime();
+      if (pconfig->rank == 3 && istep > 0)
+        assert((dset[iarray] = H5Dopen(file, path, dapl)) >= 0);
+      else
+        assert((dset[iarray] = create_dataset(pconfig, file, path, lcpl, dapl,
+                                              coll_mpi_io_flg, NULL)) >= 0);
+      op_time += MPI_Wtime();
+      *create_time += op_time;
+      if (pconfig->rank == 2 || istep == 0)
+        latency_record(plat, OP_CREATE, op_time);
+      cc_model_reset(pccm);
+
+      assert((fspace[iarray] = H5Dget_space(dset[iarray])) >= 0);
+      *create_time -= MPI_Wtime();
+      create_selection(pconfig, grid, fspace[iarray], my_proc_row, my_proc_col,
+                       istep, iarray, SELECT_BLOCK);
+      *create_time += MPI_Wtime();
+      cc_model_access(pccm, fspace[iarray]);
+    }
+
+  op_time = -MPI_Wtime();
+#pragma omp parallel for num_threads(pconfig->threads_per_rank) \
+  schedule(static, 1) reduction(+:calls)
+  for (i = 0; i < (long)pconfig->arrays; ++i)
+    {
+      double *wbuf = wbufs, t;
+#ifdef _OPENMP
+      wbuf += (size_t)omp_get_thread_num()*my_rows*my_cols;
+#endif
+#ifdef VERIFY_DATA
+      {
+        size_t d[4], o[4];
+        d[0] = step_first_flg ? pconfig->steps : pconfig->arrays;
+        d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
+        o[0] = step_first_flg ? istep : (size_t)i;
+        o[1] = step_first_flg ? (size_t)i : istep;
+        d[2] = strncmp(pconfig->scaling, "strong", 16) == 0 ?
+          pconfig->rows : pconfig->rows*pconfig->proc_rows;
+        d[3] = strncmp(pconfig->scaling, "strong", 16) == 0 ?
+          pconfig->cols : pconfig->cols*pconfig->proc_cols;
+        o[2] = my_proc_row*my_rows;
+        o[3] = my_proc_col*my_cols;
+        init_write_buffer(wbuf, &my_rows, &my_cols, d, o);
+      }
+#endif
+      t = -MPI_Wtime();
+#ifdef H5_HAVE_THREADSAFE
+      assert(H5Dwrite(dset[i], H5T_NATIVE_DOUBLE, mspace, fspace[i], dxpl,
+                      wbuf) >= 0);
+#else
+#pragma omp critical (hdf5)
+      assert(H5Dwrite(dset[i], H5T_NATIVE_DOUBLE, mspace, fspace[i], dxpl,
+                      wbuf) >= 0);
+#endif
+      t += MPI_Wtime();
+      op_times[i] = t;
+      calls += t;
+    }
+  op_time += MPI_Wtime();
+  *write_time += op_time;
+  pstats->thread_call_ns += (unsigned long long)(calls*1.0e9);
+  if (calls > op_time)
+    pstats->lock_wait_ns += (unsigned long long)((calls - op_time)*1.0e9);
+
+  for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+    {
+      latency_record(plat, OP_WRITE, op_times[iarray]);
+      assert(H5Sclose(fspace[iarray]) >= 0);
+      op_time = -MPI_Wtime();
+      assert(H5Dclose(dset[iarray]) >= 0);
+      op_time += MPI_Wtime();
+      latency_record(plat, OP_CLOSE, op_time);
+    }
+
+  free(op_times);
+  free(fspace);
+  free(dset);
+}
+
+/*
+ *
+ * Emulate the compute phase between two steps
+ *
+ */
+
+static void compute_phase(int rank, hid_t file, hid_t fapl, duration delay,
+                          io_stats* pstats)
+{
+  double t = -MPI_Wtime();
+  if (rank == 0)
+    printf("Write Computing... \n");
+  async_sleep(file, fapl, delay);
+  t += MPI_Wtime();
+  pstats->compute_ns += (unsigned long long)(t*1.0e9);
+}
+
+/*
+ *
+ * Move on to the write buffer of the next step. Even though we are writing
+ * the same data at each time step, normally we would need to fill the write
+ * buffer again before outputting the next time step. With async I/O, we
+ * rotate through several buffers and wait only for the writes still in
+ * flight from the buffer about to be reused.
+ *
+ */
+
+static unsigned int next_write_buffer(unsigned int istep, unsigned int nbuf,
+                                      hid_t es_buf[], time_step* es,
+                                      io_stats* pstats)
+{
+  unsigned int ibuf = (istep + 1) % nbuf;
+#if H5_VERSION_GE(1,14,0)
+  size_t num_in_progress;
+  hbool_t op_failed;
+  double t;
+
+  if(es != NULL)
+    {
+      t = -MPI_Wtime();
+      H5ESwait(es_buf[ibuf], H5ES_WAIT_FOREVER, &num_in_progress, &op_failed);
+      t += MPI_Wtime();
+      pstats->async_wait_ns += (unsigned long long)(t*1.0e9);
+      es->es_data = es_buf[ibuf];
+    }
+#endif
+  return ibuf;
+}
+
 void write_test
 (
  configuration* pconfig,
@@ -63,6 +405,7 @@ void write_test
  int my_proc_col,
  unsigned long my_rows,
  unsigned long my_cols,
+ double* wbufs,
  hid_t fcpl,
  hid_t fapl,
  hid_t lcpl,
@@ -70,14 +413,27 @@ void write_test
  hid_t dxpl,
  unsigned int coll_mpi_io_flg,
  double* create_time,
- double* write_time
+ double* write_time,
+ latency* plat,
+ io_stats* pstats
  )
 {
-  unsigned int step_first_flg;
-  unsigned int istep, iarray;
+  unsigned int step_first_flg, multi_flg, direct_flg;
+  unsigned int istep, iarray, nbuf, ibuf;
   double *wbuf;
+  hid_t *es_buf = NULL;
   hid_t mspace;
+  hid_t *mdset = NULL, *mtype = NULL, *mmspace = NULL, *mfspace = NULL;
+  const void **mbuf = NULL;
+#ifdef VERIFY_DATA
+  double *mwbuf = NULL;
+#endif
+#if H5_VERSION_GE(1,14,0)
   size_t i;
+#endif
+  double op_time;
+  cc_model ccm;
+  proc_grid grid;
 
   char path[255];
 
@@ -101,8 +457,14 @@ void write_test
 #endif
 
   step_first_flg = (strncmp(pconfig->slowest_dimension, "step", 16) == 0);
+  /* the rank encodes and writes whole chunks itself (see write_chunks) */
+  direct_flg = (strncmp(pconfig->chunk_write, "direct", 16) == 0);
 
-  wbuf = (double*) malloc(my_rows*my_cols*sizeof(double));
+  /* with async I/O, several steps can be in flight, one per write buffer
+     (the caller filled wbufs with nbuf blocks) */
+  nbuf = (pconfig->async == 1) ? pconfig->async_buffers : 1;
+  ibuf = 0;
+  wbuf = wbufs;
   { /* create the in-memory dataspace */
     hsize_t dims[2];
     dims[0] = (hsize_t)my_rows;
@@ -111,6 +473,28 @@ void write_test
     assert(H5Sselect_all(mspace) >= 0);
   }
 
+  write_grid(pconfig, &grid);
+  cc_model_init(&ccm, pconfig);
+
+  /* multi-dataset I/O batches the arrays of a step into one H5Dwrite_multi */
+  multi_flg = (pconfig->multi_dataset == 1);
+  if (multi_flg)
+    {
+      mdset   = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mtype   = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mmspace = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mfspace = (hid_t*) malloc(pconfig->arrays*sizeof(hid_t));
+      mbuf    = (const void**) malloc(pconfig->arrays*sizeof(void*));
+#ifdef VERIFY_DATA
+      mwbuf = (double*) malloc(nbuf*pconfig->arrays*my_rows*my_cols*sizeof(double));
+#endif
+      for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+        {
+          mtype[iarray]   = H5T_NATIVE_DOUBLE;
+          mmspace[iarray] = mspace;
+        }
+    }
+
 #ifdef VERIFY_DATA
   unsigned int strong_scaling_flg;
   strong_scaling_flg = (strncmp(pconfig->scaling, "strong", 16) == 0);
@@ -118,37 +502,10 @@ void write_test
   d[2] = strong_scaling_flg ? pconfig->rows : pconfig->rows * pconfig->proc_rows;
   d[3] = strong_scaling_flg ? pconfig->cols : pconfig->cols * pconfig->proc_cols;
 
-  o[2] = strong_scaling_flg ? rank * my_rows : my_proc_row * pconfig->rows;
-  o[3] = strong_scaling_flg ? rank * my_cols : my_proc_col * pconfig->cols;
+  o[2] = my_proc_row * my_rows;
+  o[3] = my_proc_col * my_cols;
   if (rank == 0)
     printf("\n\033[1;31m WARNING: Data verification enabled. Timings will be distorted!!!\033[0m\n");
-#else
-
-  /* add varability to data when compression is enabled */
-  if (strncmp(pconfig->compress_type, "", 16) != 1) {
-    float deltax, deltay;
-    float x, y;
-    size_t ii;
-    size_t j;
-    float x0 = 0.5f;
-    float y0 = 0.5f;
-
-    deltax = 1.f/( pconfig->rows-1);
-    deltay = 1.f/( pconfig->cols-1);
-
-    y = deltay;
-    for(j = 0, ii = 0; j < (size_t)my_cols; j++) {
-      x = deltax;
-      for(i = 0; i < (size_t)my_rows; i++, ii++) {
-        wbuf[ii] = (x-x0)*(x-x0) + (y-y0)*(y-y0);
-        x += deltax;
-      }
-      y += deltay;
-    }
-  } else {
-    for (i = 0; i < (size_t)my_rows*my_cols; ++i)
-      wbuf[i] = (double) (my_proc_row + my_proc_col);
-  }
 #endif
 
   *create_time -= MPI_Wtime();
@@ -168,7 +525,10 @@ void write_test
 #if H5_VERSION_GE(1,14,0)
   if (pconfig->async == 1) {
     es    = calloc(1, sizeof(time_step));
-    es->es_data      = H5EScreate();
+    es_buf = (hid_t*) malloc(nbuf*sizeof(hid_t));
+    for (i = 0; i < nbuf; ++i)
+      es_buf[i] = H5EScreate();
+    es->es_data      = es_buf[0];
     es->es_meta_data = H5EScreate();
   }
 #endif
@@ -178,10 +538,13 @@ void write_test
     case 4:
       {
         /* a single 4D array */
-        *create_time -= MPI_Wtime();
+        op_time = -MPI_Wtime();
         assert((dset = create_dataset(pconfig, file, "dataset", lcpl, dapl, coll_mpi_io_flg, es))
                >= 0);
-        *create_time += MPI_Wtime();
+        op_time += MPI_Wtime();
+        *create_time += op_time;
+        latency_record(plat, OP_CREATE, op_time);
+        cc_model_reset(&ccm);
 
         for (istep = 0; istep < pconfig->steps; ++istep)
           {
@@ -196,11 +559,12 @@ void write_test
 #endif
                 assert((fspace = H5Dget_space(dset)) >= 0);
                 *create_time -= MPI_Wtime();
-                create_selection(pconfig, fspace, my_proc_row, my_proc_col,
-                                 istep, iarray);
+                create_selection(pconfig, &grid, fspace, my_proc_row, my_proc_col,
+                                 istep, iarray, SELECT_BLOCK);
                 *create_time += MPI_Wtime();
+                cc_model_access(&ccm, fspace);
 
-                *write_time -= MPI_Wtime();
+                op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
                 if(es != NULL)
                   assert(H5Dwrite_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf, es->es_data) >= 0);
@@ -208,32 +572,31 @@ void write_test
 #endif
                   assert(H5Dwrite(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf) >= 0);
 
-                *write_time += MPI_Wtime();
+                op_time += MPI_Wtime();
+                *write_time += op_time;
+                if (es == NULL)
+                  get_mpio_stats(dxpl, 0, pstats);
+                latency_record(plat, OP_WRITE, op_time);
                 assert(H5Sclose(fspace) >= 0);
               }
             
             /* Simulate the compute phase */
             if (pconfig->delay.enable == 1) {
-              if (istep != pconfig->steps - 1) { // no sleep after the last es
-                if (rank == 0)
-                  printf("Write Computing... \n");
-                async_sleep(file, fapl, pconfig->delay);
-              }
+              if (istep != pconfig->steps - 1) // no sleep after the last es
+                compute_phase(rank, file, fapl, pconfig->delay, pstats);
             }
-            /* Even though we are writing the same data at each time step, normally we would need to 
-             * fill the write buffer again before outputting the next time step. Here we
-             * make sure write has completed before "filling" the write buffer again */
-#if H5_VERSION_GE(1,14,0)
-            if(es != NULL)
-              H5ESwait(es->es_data, H5ES_WAIT_FOREVER, &num_in_progress, &op_failed);
-#endif
+            ibuf = next_write_buffer(istep, nbuf, es_buf, es, pstats);
+            wbuf = wbufs + (size_t)ibuf*my_rows*my_cols;
           }
+        op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
         if(es != NULL)
           assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
         else
 #endif
-          assert(H5Dclose(dset) >= 0); 
+          assert(H5Dclose(dset) >= 0);
+        op_time += MPI_Wtime();
+        latency_record(plat, OP_CLOSE, op_time);
       }
       break;
     case 3:
@@ -242,11 +605,14 @@ void write_test
           {
             for (istep = 0; istep < pconfig->steps; ++istep)
               {
-                *create_time -= MPI_Wtime();
                 sprintf(path, "step=%d", istep);
+                op_time = -MPI_Wtime();
                 assert((dset = create_dataset(pconfig, file, path, lcpl, dapl, coll_mpi_io_flg, es))
                        >= 0);
-                *create_time += MPI_Wtime();
+                op_time += MPI_Wtime();
+                *create_time += op_time;
+                latency_record(plat, OP_CREATE, op_time);
+                cc_model_reset(&ccm);
 
                 for (iarray = 0; iarray < pconfig->arrays; ++iarray)
                   {
@@ -257,11 +623,16 @@ void write_test
 #endif
                     assert((fspace = H5Dget_space(dset)) >= 0);
                     *create_time -= MPI_Wtime();
-                    create_selection(pconfig, fspace, my_proc_row,
-                                     my_proc_col, istep, iarray);
+                    create_selection(pconfig, &grid, fspace, my_proc_row,
+                                     my_proc_col, istep, iarray, SELECT_BLOCK);
                     *create_time += MPI_Wtime();
+                    cc_model_access(&ccm, fspace);
 
-                    *write_time -= MPI_Wtime();
+                    op_time = -MPI_Wtime();
+                    if (direct_flg)
+                      write_chunks(pconfig, dset, fspace, dxpl, wbuf, my_rows, my_cols,
+                                   pstats);
+                    else
 #if H5_VERSION_GE(1,14,0)
                     if(es != NULL)
                       assert(H5Dwrite_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf, es->es_data) >= 0);
@@ -269,91 +640,167 @@ void write_test
 #endif
                       assert(H5Dwrite(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf) >= 0);
 
-                    *write_time += MPI_Wtime();
+                    op_time += MPI_Wtime();
+                    *write_time += op_time;
+                    if (es == NULL && !direct_flg)
+                      get_mpio_stats(dxpl, 0, pstats);
+                    latency_record(plat, OP_WRITE, op_time);
                     assert(H5Sclose(fspace) >= 0);
                   }
+                op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
                 if(es != NULL)
                   assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
                 else
 #endif
                   assert(H5Dclose(dset) >= 0);
+                op_time += MPI_Wtime();
+                latency_record(plat, OP_CLOSE, op_time);
 
                 if (pconfig->delay.enable == 1) {
-                  if (istep != pconfig->steps - 1) { // no sleep after the last es
-                    if (rank == 0)
-                      printf("Write Computing... \n");
-                    async_sleep(file, fapl, pconfig->delay);
-                  }
+                  if (istep != pconfig->steps - 1) // no sleep after the last es
+                    compute_phase(rank, file, fapl, pconfig->delay, pstats);
                 }
                   
-                /* Even though we are writing the same data at each time step, normally we would need to 
-                 * fill the write buffer again before outputting the next time step. Here we
-                 * make sure write has completed before "filling" the write buffer again */
-#if H5_VERSION_GE(1,14,0)
-                if(es != NULL)
-                  H5ESwait(es->es_data, H5ES_WAIT_FOREVER, &num_in_progress, &op_failed);
-#endif
+                ibuf = next_write_buffer(istep, nbuf, es_buf, es, pstats);
+                wbuf = wbufs + (size_t)ibuf*my_rows*my_cols;
               }
           }
         else /* dataset per array */
           {
             for (istep = 0; istep < pconfig->steps; ++istep)
               {
-                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                if (multi_flg) /* all arrays of the step in one H5Dwrite_multi */
                   {
-                    sprintf(path, "array=%d", iarray);
-                    *create_time -= MPI_Wtime();
-                    if (istep > 0)
-                      assert((dset = H5Dopen(file, path, dapl)) >= 0);
+                    for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                      {
+                        sprintf(path, "array=%d", iarray);
+                        op_time = -MPI_Wtime();
+                        if (istep > 0)
+                          assert((mdset[iarray] = H5Dopen(file, path, dapl)) >= 0);
+                        else
+                          assert((mdset[iarray] = create_dataset(pconfig, file, path,
+                                                                 lcpl, dapl, coll_mpi_io_flg, es)) >= 0);
+                        op_time += MPI_Wtime();
+                        *create_time += op_time;
+                        if (istep == 0)
+                          latency_record(plat, OP_CREATE, op_time);
+                        cc_model_reset(&ccm);
+
+#ifdef VERIFY_DATA
+                        d[0] = pconfig->arrays; d[1] = pconfig->steps;
+                        o[0] = iarray; o[1] = istep;
+                        mbuf[iarray] = mwbuf + ((size_t)ibuf*pconfig->arrays + iarray)*my_rows*my_cols;
+                        init_write_buffer((double*)mbuf[iarray], &my_rows, &my_cols, d, o);
+#else
+                        mbuf[iarray] = wbuf; /* all arrays carry the same data */
+#endif
+                        assert((mfspace[iarray] = H5Dget_space(mdset[iarray])) >= 0);
+                        *create_time -= MPI_Wtime();
+                        create_selection(pconfig, &grid, mfspace[iarray], my_proc_row,
+                                         my_proc_col, istep, iarray, SELECT_BLOCK);
+                        *create_time += MPI_Wtime();
+                        cc_model_access(&ccm, mfspace[iarray]);
+                      }
+
+                    op_time = -MPI_Wtime();
+                    if (direct_flg)
+                      for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                        write_chunks(pconfig, mdset[iarray], mfspace[iarray], dxpl,
+                                     (const double*)mbuf[iarray], my_rows, my_cols, pstats);
                     else
-                      assert((dset = create_dataset(pconfig, file, path,
-                                                    lcpl, dapl, coll_mpi_io_flg, es)) >= 0);
-                    *create_time += MPI_Wtime();
+                      write_multi(pconfig->arrays, mdset, mtype, mmspace, mfspace, dxpl, mbuf, es);
+                    op_time += MPI_Wtime();
+                    *write_time += op_time;
+                    if (es == NULL && !direct_flg)
+                      get_mpio_stats(dxpl, 0, pstats);
+                    latency_record(plat, OP_WRITE, op_time);
+
+                    for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                      {
+                        assert(H5Sclose(mfspace[iarray]) >= 0);
+                        op_time = -MPI_Wtime();
+#if H5_VERSION_GE(1,14,0)
+                        if(es != NULL)
+                          assert(H5Dclose_async(mdset[iarray], es->es_meta_data) >= 0);
+                        else
+#endif
+                          assert(H5Dclose(mdset[iarray]) >= 0);
+                        op_time += MPI_Wtime();
+                        latency_record(plat, OP_CLOSE, op_time);
+                      }
+                  }
+                else if (pconfig->threads_per_rank > 1)
+                  write_arrays_threaded(pconfig, file, istep, &grid,
+                                        my_proc_row, my_proc_col, my_rows,
+                                        my_cols, wbufs, mspace, lcpl, dapl,
+                                        dxpl, coll_mpi_io_flg, create_time,
+                                        write_time, plat, &ccm, pstats);
+                else
+                  {
+                    for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                      {
+                        sprintf(path, "array=%d", iarray);
+                        op_time = -MPI_Wtime();
+                        if (istep > 0)
+                          assert((dset = H5Dopen(file, path, dapl)) >= 0);
+                        else
+                          assert((dset = create_dataset(pconfig, file, path,
+                                                        lcpl, dapl, coll_mpi_io_flg, es)) >= 0);
+                        op_time += MPI_Wtime();
+                        *create_time += op_time;
+                        if (istep == 0)
+                          latency_record(plat, OP_CREATE, op_time);
+                        cc_model_reset(&ccm);
 
 #ifdef VERIFY_DATA
-                    d[0] = pconfig->arrays; d[1] = pconfig->steps;
-                    o[0] = iarray; o[1] = istep;
-                    init_write_buffer(wbuf, &my_rows, &my_cols, d, o);
+                        d[0] = pconfig->arrays; d[1] = pconfig->steps;
+                        o[0] = iarray; o[1] = istep;
+                        init_write_buffer(wbuf, &my_rows, &my_cols, d, o);
 #endif
-                    assert((fspace = H5Dget_space(dset)) >= 0);
-                    *create_time -= MPI_Wtime();
-                    create_selection(pconfig, fspace, my_proc_row,
-                                     my_proc_col, istep, iarray);
-                    *create_time += MPI_Wtime();
+                        assert((fspace = H5Dget_space(dset)) >= 0);
+                        *create_time -= MPI_Wtime();
+                        create_selection(pconfig, &grid, fspace, my_proc_row,
+                                         my_proc_col, istep, iarray, SELECT_BLOCK);
+                        *create_time += MPI_Wtime();
+                        cc_model_access(&ccm, fspace);
 
-                    *write_time -= MPI_Wtime();
+                        op_time = -MPI_Wtime();
+                        if (direct_flg)
+                          write_chunks(pconfig, dset, fspace, dxpl, wbuf, my_rows, my_cols,
+                                       pstats);
+                        else
 #if H5_VERSION_GE(1,14,0)
-                    if(es != NULL)
-                      assert(H5Dwrite_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf, es->es_data) >= 0);
-                    else
+                        if(es != NULL)
+                          assert(H5Dwrite_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf, es->es_data) >= 0);
+                        else
 #endif
-                      assert(H5Dwrite(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf) >= 0);
+                          assert(H5Dwrite(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf) >= 0);
 
-                    *write_time += MPI_Wtime();
-                    assert(H5Sclose(fspace) >= 0);
+                        op_time += MPI_Wtime();
+                        *write_time += op_time;
+                        if (es == NULL && !direct_flg)
+                          get_mpio_stats(dxpl, 0, pstats);
+                        latency_record(plat, OP_WRITE, op_time);
+                        assert(H5Sclose(fspace) >= 0);
+                        op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
-                    if(es != NULL)
-                      assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
-                    else
+                        if(es != NULL)
+                          assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
+                        else
 #endif
-                      assert(H5Dclose(dset) >= 0); 
+                          assert(H5Dclose(dset) >= 0);
+                        op_time += MPI_Wtime();
+                        latency_record(plat, OP_CLOSE, op_time);
+                      }
                   }
 
                 if (pconfig->delay.enable == 1) {
-                  if (istep != pconfig->steps - 1) { // no sleep after the last es
-                    if (rank == 0)
-                      printf("Write Computing... \n");
-                    async_sleep(file, fapl, pconfig->delay);
-                  }
+                  if (istep != pconfig->steps - 1) // no sleep after the last es
+                    compute_phase(rank, file, fapl, pconfig->delay, pstats);
                 }
-                /* Even though we are writing the same data at each time step, normally we would need to 
-                 * fill the write buffer again before outputting the next time step. Here we
-                 * make sure write has completed before "filling" the write buffer again */
-#if H5_VERSION_GE(1,14,0)
-                if(es != NULL)
-                  H5ESwait(es->es_data, H5ES_WAIT_FOREVER, &num_in_progress, &op_failed);
-#endif
+                ibuf = next_write_buffer(istep, nbuf, es_buf, es, pstats);
+                wbuf = wbufs + (size_t)ibuf*my_rows*my_cols;
               }
           }
       }
@@ -362,66 +809,145 @@ void write_test
       {
         for (istep = 0; istep < pconfig->steps; ++istep)
           {
-            for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+            if (multi_flg) /* all arrays of the step in one H5Dwrite_multi */
               {
-                *create_time -= MPI_Wtime();
-                /* group per step or array of 2D datasets */
-                sprintf(path, (step_first_flg ?
-                               "step=%d/array=%d" : "array=%d/step=%d"),
-                        (step_first_flg ? istep : iarray),
-                        (step_first_flg ? iarray : istep));
-                assert((dset = create_dataset(pconfig, file, path,
-                                              lcpl, dapl, coll_mpi_io_flg, es)) >= 0);
-                *create_time += MPI_Wtime();
+                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                  {
+                    /* group per step or array of 2D datasets */
+                    sprintf(path, (step_first_flg ?
+                                   "step=%d/array=%d" : "array=%d/step=%d"),
+                            (step_first_flg ? istep : iarray),
+                            (step_first_flg ? iarray : istep));
+                    op_time = -MPI_Wtime();
+                    assert((mdset[iarray] = create_dataset(pconfig, file, path,
+                                                           lcpl, dapl, coll_mpi_io_flg, es)) >= 0);
+                    op_time += MPI_Wtime();
+                    *create_time += op_time;
+                    latency_record(plat, OP_CREATE, op_time);
+                    cc_model_reset(&ccm);
 
 #ifdef VERIFY_DATA
-                d[0] = step_first_flg ? pconfig->steps : pconfig->arrays;
-                d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
-                o[0] = step_first_flg ? istep : iarray;
-                o[1] = step_first_flg ? iarray : istep;
-                init_write_buffer(wbuf, &my_rows, &my_cols, d, o);
+                    d[0] = step_first_flg ? pconfig->steps : pconfig->arrays;
+                    d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
+                    o[0] = step_first_flg ? istep : iarray;
+                    o[1] = step_first_flg ? iarray : istep;
+                    mbuf[iarray] = mwbuf + ((size_t)ibuf*pconfig->arrays + iarray)*my_rows*my_cols;
+                    init_write_buffer((double*)mbuf[iarray], &my_rows, &my_cols, d, o);
+#else
+                    mbuf[iarray] = wbuf; /* all arrays carry the same data */
 #endif
 
-                assert((fspace = H5Dget_space(dset)) >= 0);
-                *create_time -= MPI_Wtime();
-                create_selection(pconfig, fspace, my_proc_row, my_proc_col,
-                                 istep, iarray);
-                *create_time += MPI_Wtime();
+                    assert((mfspace[iarray] = H5Dget_space(mdset[iarray])) >= 0);
+                    *create_time -= MPI_Wtime();
+                    create_selection(pconfig, &grid, mfspace[iarray], my_proc_row, my_proc_col,
+                                     istep, iarray, SELECT_BLOCK);
+                    *create_time += MPI_Wtime();
+                    cc_model_access(&ccm, mfspace[iarray]);
+                  }
 
-                *write_time -= MPI_Wtime();
+                op_time = -MPI_Wtime();
+                if (direct_flg)
+                  for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                    write_chunks(pconfig, mdset[iarray], mfspace[iarray], dxpl,
+                                 (const double*)mbuf[iarray], my_rows, my_cols, pstats);
+                else
+                  write_multi(pconfig->arrays, mdset, mtype, mmspace, mfspace, dxpl, mbuf, es);
+                op_time += MPI_Wtime();
+                *write_time += op_time;
+                if (es == NULL && !direct_flg)
+                  get_mpio_stats(dxpl, 0, pstats);
+                latency_record(plat, OP_WRITE, op_time);
 
+                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                  {
+                    assert(H5Sclose(mfspace[iarray]) >= 0);
+                    op_time = -MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
-                if(es != NULL) {
-                  assert(H5Dwrite_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf, es->es_data) >= 0);
-                }
-                else
+                    if(es != NULL)
+                      assert(H5Dclose_async(mdset[iarray], es->es_meta_data) >= 0);
+                    else
 #endif
-                  assert(H5Dwrite(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf) >= 0);
+                      assert(H5Dclose(mdset[iarray]) >= 0);
+                    op_time += MPI_Wtime();
+                    latency_record(plat, OP_CLOSE, op_time);
+                  }
+              }
+            else if (pconfig->threads_per_rank > 1)
+              write_arrays_threaded(pconfig, file, istep, &grid,
+                                    my_proc_row, my_proc_col, my_rows, my_cols,
+                                    wbufs, mspace, lcpl, dapl, dxpl,
+                                    coll_mpi_io_flg, create_time, write_time,
+                                    plat, &ccm, pstats);
+            else
+              {
+                for (iarray = 0; iarray < pconfig->arrays; ++iarray)
+                  {
+                    /* group per step or array of 2D datasets */
+                    sprintf(path, (step_first_flg ?
+                                   "step=%d/array=%d" : "array=%d/step=%d"),
+                            (step_first_flg ? istep : iarray),
+                            (step_first_flg ? iarray : istep));
+                    op_time = -MPI_Wtime();
+                    assert((dset = create_dataset(pconfig, file, path,
+                                                  lcpl, dapl, coll_mpi_io_flg, es)) >= 0);
+                    op_time += MPI_Wtime();
+                    *create_time += op_time;
+                    latency_record(plat, OP_CREATE, op_time);
+                    cc_model_reset(&ccm);
 
-                *write_time += MPI_Wtime();
-                assert(H5Sclose(fspace) >= 0);
+#ifdef VERIFY_DATA
+                    d[0] = step_first_flg ? pconfig->steps : pconfig->arrays;
+                    d[1] = step_first_flg ? pconfig->arrays : pconfig->steps;
+                    o[0] = step_first_flg ? istep : iarray;
+                    o[1] = step_first_flg ? iarray : istep;
+                    init_write_buffer(wbuf, &my_rows, &my_cols, d, o);
+#endif
+
+                    assert((fspace = H5Dget_space(dset)) >= 0);
+                    *create_time -= MPI_Wtime();
+                    create_selection(pconfig, &grid, fspace, my_proc_row, my_proc_col,
+                                     istep, iarray, SELECT_BLOCK);
+                    *create_time += MPI_Wtime();
+                    cc_model_access(&ccm, fspace);
+
+                    op_time = -MPI_Wtime();
+
+                    if (direct_flg)
+                      write_chunks(pconfig, dset, fspace, dxpl, wbuf, my_rows, my_cols,
+                                   pstats);
+                    else
 #if H5_VERSION_GE(1,14,0)
-                if(es != NULL)
-                  assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
-                else
+                    if(es != NULL) {
+                      assert(H5Dwrite_async(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf, es->es_data) >= 0);
+                    }
+                    else
 #endif
-                  assert(H5Dclose(dset) >= 0);
+                      assert(H5Dwrite(dset, H5T_NATIVE_DOUBLE, mspace, fspace, dxpl, wbuf) >= 0);
+
+                    op_time += MPI_Wtime();
+                    *write_time += op_time;
+                    if (es == NULL && !direct_flg)
+                      get_mpio_stats(dxpl, 0, pstats);
+                    latency_record(plat, OP_WRITE, op_time);
+                    assert(H5Sclose(fspace) >= 0);
+                    op_time = -MPI_Wtime();
+#if H5_VERSION_GE(1,14,0)
+                    if(es != NULL)
+                      assert(H5Dclose_async(dset, es->es_meta_data) >= 0);
+                    else
+#endif
+                      assert(H5Dclose(dset) >= 0);
+                    op_time += MPI_Wtime();
+                    latency_record(plat, OP_CLOSE, op_time);
+                  }
               }
 
             if (pconfig->delay.enable == 1) {
-              if (istep != pconfig->steps - 1) { // no sleep after the last ts
-                if (rank == 0)
-                  printf("Write Computing... \n");
-                async_sleep(file, fapl, pconfig->delay);
-              }
+              if (istep != pconfig->steps - 1) // no sleep after the last es
+                compute_phase(rank, file, fapl, pconfig->delay, pstats);
             }
-            /* Even though we are writing the same data at each time step, normally we would need to 
-             * fill the write buffer again before outputting the next time step. Here we
-             * make sure write has completed before "filling" the write buffer again */
-#if H5_VERSION_GE(1,14,0)
-            if(es != NULL)
-              H5ESwait(es->es_data, H5ES_WAIT_FOREVER, &num_in_progress, &op_failed); 
-#endif
+            ibuf = next_write_buffer(istep, nbuf, es_buf, es, pstats);
+            wbuf = wbufs + (size_t)ibuf*my_rows*my_cols;
           }
       }
       break;
@@ -429,12 +955,30 @@ void write_test
       break;
     }
 
+#if H5_VERSION_GE(1,14,0)
+  if(es != NULL) { /* drain the writes still in flight */
+      op_time = -MPI_Wtime();
+      for (i = 0; i < nbuf; ++i)
+        H5ESwait(es_buf[i], H5ES_WAIT_FOREVER, &num_in_progress, &op_failed);
+      op_time += MPI_Wtime();
+      pstats->async_wait_ns += (unsigned long long)(op_time*1.0e9);
+  }
+#endif
+
+  if (es == NULL)
+    {
+      get_page_buffer_stats(pconfig, file, pstats);
+      get_mdc_stats(file, 0, pstats);
+    }
+
   *create_time -= MPI_Wtime();
 #if H5_VERSION_GE(1,14,0)
   if(es != NULL) {
       H5ESwait(es->es_meta_data, H5ES_WAIT_FOREVER, &num_in_progress, &op_failed);
       H5ESclose(es->es_meta_data);
-      H5ESclose(es->es_data);
+      for (i = 0; i < nbuf; ++i)
+        H5ESclose(es_buf[i]);
+      free(es_buf);
       assert(H5Fclose_async(file, 0) >= 0);
       free(es);
   } else
@@ -442,6 +986,126 @@ void write_test
     assert(H5Fclose(file) >= 0);
 
   *create_time += MPI_Wtime();
+  pstats->write_chunk_hits   += ccm.hits;
+  pstats->write_chunk_misses += ccm.misses;
+  pstats->write_bytes        += ccm.bytes;
+  cc_model_free(&ccm);
+
   assert(H5Sclose(mspace) >= 0);
-  free(wbuf);
+  if (multi_flg)
+    {
+      free(mdset);
+      free(mtype);
+      free(mmspace);
+      free(mfspace);
+      free(mbuf);
+#ifdef VERIFY_DATA
+      free(mwbuf);
+#endif
+    }
+}
+
+/*
+ *
+ * Create the main file of the virtual layout with a virtual dataset for each
+ * dataset of the rank's source files (rank 0 only)
+ *
+ */
+
+void write_vds
+(
+ configuration* pconfig,
+ char * hdf5_filename,
+ int size,
+ hid_t fcpl,
+ hid_t fapl,
+ hid_t lcpl,
+ hid_t dapl,
+ double* create_time
+ )
+{
+  unsigned int istep, iarray, nsteps, narrays;
+  char path[255];
+  hid_t file, dset;
+
+  dataset_counts(pconfig, &nsteps, &narrays);
+
+  *create_time -= MPI_Wtime();
+  assert((file = H5Fcreate(hdf5_filename, H5F_ACC_TRUNC, fcpl, fapl)) >= 0);
+
+  for (istep = 0; istep < nsteps; ++istep)
+    for (iarray = 0; iarray < narrays; ++iarray)
+      {
+        dataset_path(pconfig, istep, iarray, path);
+        assert((dset = create_virtual_dataset(pconfig, file, path, lcpl, dapl,
+                                              hdf5_filename, size)) >= 0);
+        assert(H5Dclose(dset) >= 0);
+      }
+
+  assert(H5Fclose(file) >= 0);
+  *create_time += MPI_Wtime();
+}
+
+/*
+ *
+ * Add the datasets' storage and logical size to the stats (the case's rank 0
+ * only). This runs after a repetition, outside the timings: only chunked
+ * datasets may be filtered, so the file is reopened to ask for their storage
+ * size, and the other layouts take up their logical size. (The virtual
+ * layout's sources hold the ranks' unfiltered blocks.) We don't ask with async
+ * I/O, where the file may still be closing.
+ *
+ */
+
+void write_storage
+(
+ configuration* pconfig,
+ char * hdf5_filename,
+ int rank,
+ hid_t fapl,
+ hid_t dapl,
+ io_stats* pstats
+ )
+{
+  unsigned int istep, iarray, nsteps, narrays;
+  char path[255];
+  hid_t file, dset, fspace;
+  unsigned long long nbytes;
+  proc_grid w;
+
+  if (pconfig->async)
+    return;
+
+  if (strncmp(pconfig->layout, "chunked", 16) != 0)
+    {
+      if (rank == 0)
+        {
+          write_grid(pconfig, &w);
+          nbytes = (unsigned long long)pconfig->steps*pconfig->arrays*
+            w.proc_rows*w.my_rows*w.proc_cols*w.my_cols*sizeof(double);
+          pstats->storage_bytes += nbytes;
+          pstats->dataset_bytes += nbytes;
+        }
+      return;
+    }
+
+  dataset_counts(pconfig, &nsteps, &narrays);
+  assert((file = H5Fopen(hdf5_filename, H5F_ACC_RDONLY, fapl)) >= 0);
+  for (istep = 0; istep < nsteps; ++istep)
+    for (iarray = 0; iarray < narrays; ++iarray)
+      {
+        dataset_path(pconfig, istep, iarray, path);
+        assert((dset = H5Dopen(file, path, dapl)) >= 0);
+        if (rank == 0)
+          {
+            assert((fspace = H5Dget_space(dset)) >= 0);
+            pstats->storage_bytes += (unsigned long long)
+              H5Dget_storage_size(dset);
+            pstats->dataset_bytes += (unsigned long long)
+              H5Sget_simple_extent_npoints(fspace)*sizeof(double);
+            assert(H5Sclose(fspace) >= 0);
+          }
+        assert(H5Dclose(dset) >= 0);
+      }
+  assert(H5Fclose(file) >= 0);
 }
@@ -15,6 +15,7 @@
 #define WRITE_TEST_H
 
 #include "configuration.h"
+#include "utils.h"
 #include "hdf5.h"
 
 extern void write_test
@@ -27,6 +28,7 @@ extern void write_test
  int my_proc_col,
  unsigned long my_rows,
  unsigned long my_cols,
+ double* wbufs,
  hid_t fcpl,
  hid_t fapl,
  hid_t lcpl,
@@ -34,7 +36,31 @@ extern void write_test
  hid_t dxpl,
  unsigned int coll_mpi_io_flg,
  double* create_time,
- double* write_time
+ double* write_time,
+ latency* plat,
+ io_stats* pstats
+ );
+
+extern void write_storage
+(
+ configuration* pconfig,
+ char * hdf5_filename,
+ int rank,
+ hid_t fapl,
+ hid_t dapl,
+ io_stats* pstats
+ );
+
+extern void write_vds
+(
+ configuration* pconfig,
+ char * hdf5_filename,
+ int size,
+ hid_t fcpl,
+ hid_t fapl,
+ hid_t lcpl,
+ hid_t dapl,
+ double* create_time
  );
 
 #endif